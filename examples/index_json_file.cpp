@@ -0,0 +1,33 @@
+/**
+ * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
+ */
+
+#include <iostream>
+#include "json.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc == 4 && std::string(argv[1]) == "build")
+    {
+        auto index = json::Index::build(argv[2]);
+        index.save(argv[3]);
+        std::cout << index.size() << " entries indexed" << std::endl;
+        return 0;
+    }
+    if (argc == 5 && std::string(argv[1]) == "get")
+    {
+        auto index = json::Index::load(argv[3]);
+        if (index.type() == json::Type::Array)
+        {
+            std::cout << index.get(argv[2], std::stoul(argv[4])) << std::endl;
+        }
+        else
+        {
+            std::cout << index.get(argv[2], std::string_view(argv[4])) << std::endl;
+        }
+        return 0;
+    }
+    std::cerr << "usage: " << argv[0] << " build <file.json> <file.idx>" << std::endl;
+    std::cerr << "       " << argv[0] << " get <file.json> <file.idx> <position|key>" << std::endl;
+    return 1;
+}
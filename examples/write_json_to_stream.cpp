@@ -0,0 +1,24 @@
+/**
+ * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
+ */
+
+#include <iostream>
+#include "json.h"
+
+int main()
+{
+    json::Writer writer(std::cout, true);
+    writer.beginObject();
+    writer.key("key1").value(1);
+    writer.key("key2").beginArray();
+    for (int i = 0; i < 5; ++i)
+    {
+        writer.value(i * 1.5);
+    }
+    writer.endArray();
+    writer.key("key3").value(json::parse("{\"key4\": \"abc\"}"));
+    writer.endObject();
+    writer.flush();
+    std::cout << std::endl;
+    return 0;
+}
@@ -7,13 +7,35 @@
 
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <list>
 #include <map>
+#include <optional>
 #include <initializer_list>
 #include <type_traits>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace json {
 
@@ -31,8 +53,24 @@ enum class Type : std::uint16_t
 class Error : public std::runtime_error
 {
 public:
+    static constexpr std::size_t npos = std::string::npos;
+
     Error(const std::string& message) : runtime_error(message)
     {}
+
+    Error(const std::string& message, std::size_t offset) :
+        runtime_error(message + " at offset " + std::to_string(offset)), offset_(offset)
+    {}
+
+    /**
+     * Byte offset in the input at which parsing failed, or npos if the error is not a parse error.
+     */
+    [[nodiscard]] std::size_t offset() const
+    {
+        return offset_;
+    }
+private:
+    std::size_t offset_{npos};
 }; /* End of class Error */
 
 class Key
@@ -54,30 +92,579 @@ private:
     std::string str_;
 }; /* End of class Key */
 
+namespace detail {
+
+/**
+ * Returns the length of the leading run of bytes that a string parser can copy verbatim,
+ * i.e. up to the first quote, backslash, control character or non-ASCII byte.
+ */
+inline std::size_t scanPlainInput(const char *data, std::size_t size)
+{
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        int mask = _mm_movemask_epi8(_mm_or_si128(special, chunk));
+        if (mask != 0) { return i + __builtin_ctz(mask); }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        auto c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) { break; }
+    }
+    return i;
+}
+
+/**
+ * Returns the length of the leading run of bytes that can be written out verbatim inside
+ * a JSON string, i.e. up to the first quote, backslash or control character.
+ */
+inline std::size_t scanPlainOutput(const char *data, std::size_t size)
+{
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) { return i + __builtin_ctz(mask); }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        auto c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20) { break; }
+    }
+    return i;
+}
+
+/**
+ * Returns the length of a well-formed UTF-8 sequence at the beginning of data, or 0 if the bytes
+ * are not valid UTF-8 (overlong forms, surrogates and code points above U+10FFFF are rejected).
+ */
+inline std::size_t utf8SequenceLength(const char *data, std::size_t size)
+{
+    auto byte = [data](std::size_t i) { return static_cast<unsigned char>(data[i]); };
+    auto c = byte(0);
+    if (c < 0x80) { return 1; }
+
+    std::size_t length;
+    unsigned char low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) { length = 2; }
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+        length = 3;
+        if (c == 0xE0) { low = 0xA0; }
+        if (c == 0xED) { high = 0x9F; }
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+        length = 4;
+        if (c == 0xF0) { low = 0x90; }
+        if (c == 0xF4) { high = 0x8F; }
+    }
+    else { return 0; }
+
+    if (size < length) { return 0; }
+    if (byte(1) < low || byte(1) > high) { return 0; }
+    for (std::size_t i = 2; i < length; ++i)
+    {
+        if (byte(i) < 0x80 || byte(i) > 0xBF) { return 0; }
+    }
+    return length;
+}
+
+inline void appendUtf8(std::string& out, std::uint32_t codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        out += static_cast<char>(codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+/**
+ * Appends text to out as a quoted JSON string, escaping quotes, backslashes and control characters.
+ */
+inline void appendQuoted(std::string& out, std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    std::size_t start = 0;
+    for (;;)
+    {
+        std::size_t pos = start + scanPlainOutput(text.data() + start, text.size() - start);
+        out.append(text.data() + start, pos - start);
+        if (pos == text.size()) { break; }
+        auto c = static_cast<unsigned char>(text[pos]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0x0F];
+                break;
+        }
+        start = pos + 1;
+    }
+    out += '"';
+}
+
+inline std::string quote(std::string_view text)
+{
+    std::string result;
+    result.reserve(text.size() + 2);
+    appendQuoted(result, text);
+    return result;
+}
+
+/**
+ * Returns the decimal exponent of the leading digit of a number in JSON syntax, e.g. 2 for
+ * "123.4" and -3 for "0.00123", without converting it. The result saturates far outside the
+ * range of double.
+ */
+inline long decimalExponent(const char *first, const char *last)
+{
+    const char *p = first + ((*first == '-') ? 1 : 0);
+    bool zero = (*p == '0');
+    long exponent = -1;
+    for (; p != last && *p >= '0' && *p <= '9'; ++p) { ++exponent; }
+    if (zero && p != last && *p == '.')
+    {
+        for (++p; p != last && *p == '0'; ++p) { --exponent; }
+        --exponent;
+    }
+    while (p != last && *p != 'e' && *p != 'E') { ++p; }
+    if (p != last)
+    {
+        ++p;
+        bool below = (*p == '-');
+        if (*p == '-' || *p == '+') { ++p; }
+        long power = 0;
+        for (; p != last; ++p) { power = std::min(power * 10 + (*p - '0'), 1000000L); }
+        exponent += below ? -power : power;
+    }
+    return exponent;
+}
+
+/**
+ * Converts a number in JSON syntax to double. A value too small to be represented becomes zero,
+ * as strtod() does; false is returned only when the value is too large.
+ */
+inline bool toDouble(const char *first, const char *last, double& value)
+{
+    auto result = std::from_chars(first, last, value);
+    if (result.ec == std::errc()) { return true; }
+    if (result.ec != std::errc::result_out_of_range || decimalExponent(first, last) >= 0) { return false; }
+    value = (*first == '-') ? -0.0 : 0.0;
+    return true;
+}
+
+} /* End of namespace detail */
+
 Key operator "" _(const char *str, std::size_t len)
 {
     return Key(str, len);
 }
 
+class Schema;
+
+/**
+ * Set of key paths selecting the members a projected parse materializes, compiled once into a trie.
+ * A path selects the whole value found at its end; members outside every path are skipped.
+ */
+class Projection
+{
+public:
+    class Node
+    {
+    public:
+        [[nodiscard]] bool isLeaf() const
+        {
+            return leaf_;
+        }
+
+        [[nodiscard]] const Node *find(std::string_view key) const
+        {
+            auto it = children_.find(key);
+            return (it != children_.end()) ? it->second.get() : nullptr;
+        }
+    private:
+        friend class Projection;
+
+        bool leaf_{};
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children_;
+    }; /* End of subclass Node */
+
+    Projection()
+    {}
+
+    Projection(std::initializer_list<std::string_view> paths, char separator = '.')
+    {
+        for (auto path: paths)
+        {
+            add(path, separator);
+        }
+    }
+
+    Projection& add(std::string_view path, char separator = '.')
+    {
+        std::vector<std::string> keys;
+        for (;;)
+        {
+            auto pos = path.find(separator);
+            keys.emplace_back(path.substr(0, pos));
+            if (pos == std::string_view::npos) { break; }
+            path.remove_prefix(pos + 1);
+        }
+        return add(keys);
+    }
+
+    Projection& add(const std::vector<std::string>& keys)
+    {
+        Node *node = &root_;
+        for (auto& key: keys)
+        {
+            if (node->leaf_) { return *this; }
+            auto& child = node->children_[key];
+            if (!child) { child = std::make_unique<Node>(); }
+            node = child.get();
+        }
+        node->leaf_ = true;
+        node->children_.clear();
+        return *this;
+    }
+
+    [[nodiscard]] const Node& root() const
+    {
+        return root_;
+    }
+private:
+    Node root_;
+}; /* End of class Projection */
+
 class Object
 {
 public:
+    using Elements = std::vector<Object>;
+    using Members = std::map<std::string, Object, std::less<>>;
+
+    /**
+     * Bidirectional iterator over the elements of an array or the member values of an object;
+     * key() gives the member name without copying it.
+     */
+    template <bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Object;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Object *, Object *>;
+        using reference = std::conditional_t<Const, const Object&, Object&>;
+
+        Iterator() = default;
+
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) :
+            element_(other.element_), member_(other.member_), is_member_(other.is_member_)
+        {}
+
+        [[nodiscard]] std::string_view key() const
+        {
+            return is_member_ ? std::string_view(member_->first) : std::string_view();
+        }
+
+        reference value() const
+        {
+            return is_member_ ? member_->second : *element_;
+        }
+
+        reference operator*() const
+        {
+            return value();
+        }
+
+        pointer operator->() const
+        {
+            return &value();
+        }
+
+        Iterator& operator++()
+        {
+            if (is_member_) { ++member_; } else { ++element_; }
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        Iterator& operator--()
+        {
+            if (is_member_) { --member_; } else { --element_; }
+            return *this;
+        }
+
+        Iterator operator--(int)
+        {
+            Iterator result = *this;
+            --*this;
+            return result;
+        }
+
+        /**
+         * Hidden friends, so that an iterator converts to const_iterator on either side of a mixed
+         * comparison.
+         */
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs.is_member_ ? lhs.member_ == rhs.member_ : lhs.element_ == rhs.element_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs)
+        {
+            return !(lhs == rhs);
+        }
+    private:
+        friend class Object;
+        friend class Iterator<!Const>;
+
+        using ElementIterator = std::conditional_t<Const, Elements::const_iterator, Elements::iterator>;
+        using MemberIterator = std::conditional_t<Const, Members::const_iterator, Members::iterator>;
+
+        explicit Iterator(ElementIterator element) :
+            element_(element)
+        {}
+
+        explicit Iterator(MemberIterator member) :
+            member_(member), is_member_(true)
+        {}
+
+        ElementIterator element_{};
+        MemberIterator member_{};
+        bool is_member_{};
+    }; /* End of subclass Iterator */
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    /**
+     * Forward range of (key, value) pairs over the members of an object, or over the elements
+     * of an array with empty keys.
+     */
+    class Items
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+            using value_type = std::pair<std::string_view, const Object&>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            iterator() = default;
+
+            explicit iterator(const_iterator it) :
+                it_(it)
+            {}
+
+            reference operator*() const
+            {
+                return {it_.key(), it_.value()};
+            }
+
+            iterator& operator++()
+            {
+                ++it_;
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator result = *this;
+                ++it_;
+                return result;
+            }
+
+            bool operator==(const iterator& rhs) const
+            {
+                return it_ == rhs.it_;
+            }
+
+            bool operator!=(const iterator& rhs) const
+            {
+                return it_ != rhs.it_;
+            }
+        private:
+            const_iterator it_;
+        }; /* End of subclass iterator */
+
+        Items(const_iterator first, const_iterator last) :
+            first_(first), last_(last)
+        {}
+
+        [[nodiscard]] iterator begin() const
+        {
+            return iterator(first_);
+        }
+
+        [[nodiscard]] iterator end() const
+        {
+            return iterator(last_);
+        }
+    private:
+        const_iterator first_;
+        const_iterator last_;
+    }; /* End of subclass Items */
+
     class Parser
     {
     public:
+        struct Options
+        {
+            /**
+             * The parser itself does not recurse, but destroying, hashing, comparing, writing and
+             * schema-validating a tree do, one call per level. Raising this far above the default
+             * lets hostile input overflow the stack later, outside of the parser.
+             */
+            std::size_t maxDepth = 1024;
+            std::size_t maxBytes = std::numeric_limits<std::size_t>::max();
+            std::size_t maxStringLength = std::numeric_limits<std::size_t>::max();
+            std::size_t maxMembers = std::numeric_limits<std::size_t>::max();
+            /**
+             * Keep numbers as their raw text and decode them on first access; dumps() then writes
+             * the original text back unchanged.
+             */
+            bool lazyNumbers = false;
+        }; /* End of struct Options */
+
         Parser()
         {}
 
-        Object fromString(const std::string& input)
+        explicit Parser(const Options& options) :
+            options_(options)
+        {}
+
+        Object fromString(std::string_view input)
         {
-            input_ = input;
-            index_ = 0;
-            return parseValue();
+            Object result;
+            parse(input, result);
+            return result;
+        }
+
+        /**
+         * Parses input into an existing object, reusing its strings, containers and member nodes
+         * wherever the new document has the same shape. Together with the scratch buffers kept by
+         * the parser between calls, this makes repeated parsing of same-shaped documents nearly
+         * allocation-free. If parsing fails, result is left valid but unspecified.
+         */
+        void fromString(std::string_view input, Object& result)
+        {
+            parse(input, result);
+        }
+
+        /**
+         * Parses only the members selected by projection. Everything else is validated and skipped
+         * without allocating or decoding; values that do not match a path are left out, and a
+         * document that is not an object yields null.
+         */
+        Object fromString(std::string_view input, const Projection& projection)
+        {
+            Object result;
+            parse(input, result, &projection.root());
+            return result;
+        }
+
+        void fromString(std::string_view input, const Projection& projection, Object& result)
+        {
+            parse(input, result, &projection.root());
+        }
+
+        /**
+         * Parses input while validating it against schema, failing at the first violation
+         * instead of building the whole tree first.
+         */
+        Object fromString(std::string_view input, const Schema& schema)
+        {
+            Object result;
+            parse(input, result, nullptr, &schema);
+            return result;
+        }
+
+        void fromString(std::string_view input, const Schema& schema, Object& result)
+        {
+            parse(input, result, nullptr, &schema);
         }
 
     private:
-        std::string input_;
-        size_t index_;
+        struct Frame
+        {
+            Object *target;
+            bool is_object;
+            bool reused;
+            std::size_t members;
+            std::size_t touched;
+            const Projection::Node *projection;
+            std::size_t schema;
+        }; /* End of struct Frame */
+
+        Options options_;
+        std::string_view input_;
+        std::size_t index_{};
+        std::vector<Frame> stack_;
+        std::vector<const Object *> touched_;
+        std::string key_;
+        std::string skipped_;
+        const Projection::Node *projection_{};
+        const Schema *schema_{};
+        std::size_t schemaNode_{};
+
+        [[noreturn]] void fail(const std::string& reason) const
+        {
+            throw Error("Invalid JSON: " + reason, index_);
+        }
 
         [[nodiscard]] char peek() const
         {
@@ -89,460 +676,2876 @@ public:
             return (index_ < input_.size()) ? input_[index_++] : '\0';
         }
 
-        void eatWhitespace()
+        void expect(char c)
         {
-            while (std::isspace(peek())) { get(); }
+            if (peek() != c)
+            {
+                fail(std::string("expected '") + c + "'");
+            }
+            ++index_;
         }
 
-        Object parseValue()
+        void eatWhitespace()
         {
-            eatWhitespace();
-            char c = peek();
-            if (c == '{') { return parseObject(); }
-            if (c == '[') { return parseArray(); }
-            if (c == '"') { return parseString(); }
-            if (c == 't' || c == 'f') { return parseBoolean(); }
-            if (c == 'n') { return parseNull(); }
-            if (c == '-' || std::isdigit(c)) { return parseNumber(); }
-            throw Error("Invalid JSON");
+            while (index_ < input_.size())
+            {
+                char c = input_[index_];
+                if (c != ' ' && c != '\t' && c != '\n' && c != '\r') { break; }
+                ++index_;
+            }
         }
 
-        Object parseObject()
+        /**
+         * Parses a single document into result. Nesting is tracked on an explicit stack instead of
+         * the call stack; Options::maxDepth keeps the resulting tree shallow enough for the
+         * recursive operations on Object.
+         */
+        void parse(std::string_view input, Object& result, const Projection::Node *projection = nullptr,
+                   const Schema *schema = nullptr)
         {
-            Object result(Type::Object);
-            get(); // consume '{'
-            for (;;)
+            input_ = input;
+            index_ = 0;
+            stack_.clear();
+            touched_.clear();
+            projection_ = (projection && projection->isLeaf()) ? nullptr : projection;
+            startSchema(schema);
+            if (input_.size() > options_.maxBytes)
+            {
+                index_ = options_.maxBytes;
+                fail("document too large");
+            }
+
+            Object *target = &result;
+            eatWhitespace();
+            if (projection_ && peek() != '{')
+            {
+                skipValue();
+                result.clear();
+                target = nullptr;
+            }
+            while (target)
             {
                 eatWhitespace();
-                if (peek() == '}')
+                char c = peek();
+                if (c == '{' || c == '[')
                 {
-                    get(); // consume '}'
-                    break;
+                    if (stack_.size() >= options_.maxDepth)
+                    {
+                        fail("maximum depth exceeded");
+                    }
+                    bool is_object = (c == '{');
+                    checkSchemaType(is_object ? Type::Object : Type::Array);
+                    ++index_;
+                    bool reused = prepareContainer(*target, is_object ? Type::Object : Type::Array);
+                    stack_.push_back({target, is_object, reused, 0, touched_.size(), projection_, schemaNode_});
+                    eatWhitespace();
+                    if (peek() != (is_object ? '}' : ']'))
+                    {
+                        target = beginMember(stack_.back());
+                        if (target) { continue; }
+                    }
+                    else
+                    {
+                        ++index_;
+                        endContainer(stack_.back());
+                        checkSchema(stack_.back().schema, *target, index_ - 1);
+                        stack_.pop_back();
+                    }
                 }
-                std::string key = parseString().toString();
-                eatWhitespace();
-                if (get() != ':')
+                else
                 {
-                    throw Error("Invalid JSON");
+                    std::size_t start = index_;
+                    parseScalar(*target);
+                    checkSchema(schemaNode_, *target, start);
                 }
-                Object value = parseValue();
-                result[key] = value;
-                eatWhitespace();
-                if (peek() == ',')
+
+                // A value is complete: close finished containers until another member follows.
+                while (!stack_.empty())
                 {
-                    get(); // consume ','
+                    Frame& frame = stack_.back();
+                    eatWhitespace();
+                    c = peek();
+                    if (c == ',')
+                    {
+                        ++index_;
+                        target = beginMember(frame);
+                        if (target) { break; }
+                        continue;
+                    }
+                    if (c != (frame.is_object ? '}' : ']'))
+                    {
+                        fail(frame.is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+                    }
+                    ++index_;
+                    endContainer(frame);
+                    checkSchema(frame.schema, *frame.target, index_ - 1);
+                    stack_.pop_back();
                 }
-                else if (peek() == '}')
+                if (stack_.empty())
                 {
-                    get(); // consume '}'
                     break;
                 }
-                else
-                {
-                    throw Error("Invalid JSON");
-                }
             }
-            return result;
+            eatWhitespace();
+            if (index_ != input_.size())
+            {
+                fail("unexpected trailing characters");
+            }
         }
 
-        Object parseArray()
+        /**
+         * Prepares the slot for the next member of frame, or skips the member and returns nullptr
+         * if the frame's projection does not select it.
+         */
+        Object *beginMember(Frame& frame)
         {
-            Object result(Type::Array);
-            get(); // consume '['
-            for (;;)
+            if (++frame.members > options_.maxMembers)
             {
-                eatWhitespace();
-                if (peek() == ']')
+                fail("too many members");
+            }
+            projection_ = nullptr;
+            if (!frame.is_object)
+            {
+                enterSchemaMember(frame);
+                auto& vector = *frame.target->vector_;
+                if (frame.members <= vector.size())
                 {
-                    get(); // consume ']'
-                    break;
+                    return &vector[frame.members - 1];
                 }
-                Object value = parseValue();
-                result.append(value);
-                eatWhitespace();
-                if (peek() == ',')
+                vector.emplace_back();
+                return &vector.back();
+            }
+            eatWhitespace();
+            key_.clear();
+            std::size_t key_offset = index_;
+            parseString(key_);
+            eatWhitespace();
+            expect(':');
+            enterSchemaMember(frame, key_offset);
+            if (frame.projection)
+            {
+                const Projection::Node *node = frame.projection->find(key_);
+                eatWhitespace();
+                if (!node || (!node->isLeaf() && peek() != '{'))
+                {
+                    skipValue();
+                    dropMember(frame);
+                    return nullptr;
+                }
+                projection_ = node->isLeaf() ? nullptr : node;
+            }
+            Object *member = &frame.target->map_->try_emplace(key_).first->second;
+            if (frame.reused)
+            {
+                touched_.push_back(member);
+            }
+            return member;
+        }
+
+        /**
+         * Removes a member materialized by an earlier occurrence of the key just skipped, so that
+         * the last duplicate wins as it does without a projection.
+         */
+        void dropMember(const Frame& frame)
+        {
+            auto& map = *frame.target->map_;
+            auto it = map.find(key_);
+            if (it == map.end())
+            {
+                return;
+            }
+            auto first = touched_.begin() + frame.touched;
+            touched_.erase(std::remove(first, touched_.end(), &it->second), touched_.end());
+            map.erase(it);
+        }
+
+        void startSchema(const Schema *schema);
+        void checkSchemaType(Type type) const;
+        void checkSchema(std::size_t node, const Object& value, std::size_t offset) const;
+        void enterSchemaMember(const Frame& frame, std::size_t offset = 0);
+
+        /**
+         * Turns target into an empty container of the given type. Returns true when the target
+         * already owned a non-empty container of that type, whose nodes are then reused.
+         */
+        static bool prepareContainer(Object& target, Type type)
+        {
+            if (target.type_ != type)
+            {
+                target.setType(type);
+            }
+            target.hash_.reset();
+            target.string_.clear();
+            if (type == Type::Array)
+            {
+                if (!target.vector_ || target.vector_.use_count() > 1)
+                {
+                    target.vector_ = std::make_shared<Elements>();
+                }
+                return !target.vector_->empty();
+            }
+            if (!target.map_ || target.map_.use_count() > 1)
+            {
+                target.map_ = std::make_shared<Members>();
+            }
+            return !target.map_->empty();
+        }
+
+        /**
+         * Drops nodes left over from the previous content of a reused container.
+         */
+        void endContainer(const Frame& frame)
+        {
+            if (!frame.reused)
+            {
+                return;
+            }
+            if (!frame.is_object)
+            {
+                frame.target->vector_->resize(frame.members);
+                return;
+            }
+            auto& map = *frame.target->map_;
+            auto first = touched_.begin() + frame.touched;
+            std::sort(first, touched_.end());
+            auto last = std::unique(first, touched_.end());
+            if (static_cast<std::size_t>(last - first) != map.size())
+            {
+                for (auto it = map.begin(); it != map.end();)
+                {
+                    if (std::binary_search(first, last, &it->second)) { ++it; }
+                    else { it = map.erase(it); }
+                }
+            }
+            touched_.resize(frame.touched);
+        }
+
+        void parseScalar(Object& target)
+        {
+            char c = peek();
+            if (c == '"')
+            {
+                target.setType(Type::String);
+                parseString(target.string_);
+            }
+            else if (c == 't' || c == 'f') { target = parseBoolean(); }
+            else if (c == 'n') { parseNull(); target.clear(); }
+            else if (c == '-' || (c >= '0' && c <= '9')) { parseNumber(target); }
+            else if (c == '\0' && index_ == input_.size()) { fail("unexpected end of input"); }
+            else { fail("unexpected character"); }
+        }
+
+        void parseString(std::string& out)
+        {
+            scanString(&out);
+        }
+
+        void skipString()
+        {
+            scanString(nullptr);
+        }
+
+        /**
+         * Validates the string at the current position and appends its decoded contents to out,
+         * unless out is null.
+         */
+        void scanString(std::string *out)
+        {
+            expect('"');
+            std::size_t start = index_;
+            std::size_t length = 0;
+            for (;;)
+            {
+                std::size_t pending = index_ - start;
+                if (length + pending > options_.maxStringLength)
+                {
+                    fail("string too long");
+                }
+                std::size_t room = options_.maxStringLength - length - pending;
+                index_ += detail::scanPlainInput(input_.data() + index_, std::min(input_.size() - index_, room));
+                if (index_ >= input_.size())
+                {
+                    fail("unterminated string");
+                }
+                char c = input_[index_];
+                if (c == '"')
+                {
+                    if (out) { out->append(input_, start, index_ - start); }
+                    ++index_;
+                    return;
+                }
+                if (c == '\\')
+                {
+                    if (out) { out->append(input_, start, index_ - start); }
+                    length += index_ - start;
+                    ++index_;
+                    std::uint32_t codepoint = parseEscape();
+                    length += (codepoint < 0x80) ? 1 : (codepoint < 0x800) ? 2 : (codepoint < 0x10000) ? 3 : 4;
+                    if (out) { detail::appendUtf8(*out, codepoint); }
+                    start = index_;
+                    continue;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    fail("unescaped control character");
+                }
+                std::size_t sequence = detail::utf8SequenceLength(input_.data() + index_, input_.size() - index_);
+                if (sequence == 0)
+                {
+                    fail("invalid UTF-8 sequence");
+                }
+                index_ += sequence;
+            }
+        }
+
+        std::uint32_t parseEscape()
+        {
+            switch (get()) {
+                case '"': return '"';
+                case '\\': return '\\';
+                case '/': return '/';
+                case 'b': return '\b';
+                case 'f': return '\f';
+                case 'n': return '\n';
+                case 'r': return '\r';
+                case 't': return '\t';
+                case 'u': break;
+                default: fail("invalid escape sequence");
+            }
+            std::uint32_t codepoint = parseHex4();
+            if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+            {
+                fail("unpaired surrogate");
+            }
+            if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+            {
+                if (get() != '\\' || get() != 'u')
+                {
+                    fail("unpaired surrogate");
+                }
+                std::uint32_t low = parseHex4();
+                if (low < 0xDC00 || low > 0xDFFF)
+                {
+                    fail("unpaired surrogate");
+                }
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            return codepoint;
+        }
+
+        std::uint32_t parseHex4()
+        {
+            std::uint32_t value = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = get();
+                value <<= 4;
+                if (c >= '0' && c <= '9') { value |= c - '0'; }
+                else if (c >= 'a' && c <= 'f') { value |= c - 'a' + 10; }
+                else if (c >= 'A' && c <= 'F') { value |= c - 'A' + 10; }
+                else { fail("invalid escape sequence"); }
+            }
+            return value;
+        }
+
+        /**
+         * Validates the number at the current position and returns whether it has a fraction
+         * or an exponent.
+         */
+        bool scanNumber()
+        {
+            auto digits = [this]() {
+                std::size_t start = index_;
+                while (peek() >= '0' && peek() <= '9') { ++index_; }
+                return index_ - start;
+            };
+
+            bool is_float = false;
+            if (peek() == '-') { ++index_; }
+            std::size_t integral = digits();
+            if (integral == 0)
+            {
+                fail("invalid number");
+            }
+            if (integral > 1 && input_[index_ - integral] == '0')
+            {
+                fail("invalid number");
+            }
+            if (peek() == '.')
+            {
+                ++index_;
+                if (digits() == 0)
+                {
+                    fail("invalid number");
+                }
+                is_float = true;
+            }
+            if (peek() == 'e' || peek() == 'E')
+            {
+                ++index_;
+                if (peek() == '+' || peek() == '-') { ++index_; }
+                if (digits() == 0)
+                {
+                    fail("invalid number");
+                }
+                is_float = true;
+            }
+            return is_float;
+        }
+
+        void parseNumber(Object& target)
+        {
+            std::size_t start = index_;
+            bool is_float = scanNumber();
+            const char *first = input_.data() + start;
+            const char *last = input_.data() + index_;
+            if (options_.lazyNumbers)
+            {
+                // Only numbers near the top of the double range need converting to rule out overflow.
+                double value;
+                if (detail::decimalExponent(first, last) >= std::numeric_limits<double>::max_exponent10
+                    && !detail::toDouble(first, last, value))
+                {
+                    index_ = start;
+                    fail("number out of range");
+                }
+                bool is_integer = !is_float && fitsInteger(std::string_view(first, last - first));
+                target.setType(is_integer ? Type::Integer : Type::Double);
+                target.string_.assign(first, last);
+                target.raw_.set();
+                return;
+            }
+            if (!is_float)
+            {
+                std::int64_t value;
+                if (std::from_chars(first, last, value).ec == std::errc())
+                {
+                    target = value;
+                    return;
+                }
+            }
+            double value;
+            if (!detail::toDouble(first, last, value))
+            {
+                index_ = start;
+                fail("number out of range");
+            }
+            target = value;
+        }
+
+        /**
+         * Tells whether a number in integer syntax fits into std::int64_t, without converting it.
+         */
+        static bool fitsInteger(std::string_view text)
+        {
+            std::string_view limit = "9223372036854775807";
+            if (text.front() == '-')
+            {
+                text.remove_prefix(1);
+                limit = "9223372036854775808";
+            }
+            return text.size() < limit.size() || (text.size() == limit.size() && text <= limit);
+        }
+
+        /**
+         * Validates and skips the value at the current position without building or decoding
+         * anything. Open brackets are tracked in a reused buffer, so skipping does not allocate.
+         */
+        void skipValue()
+        {
+            skipped_.clear();
+            for (;;)
+            {
+                eatWhitespace();
+                char c = peek();
+                if (c == '{' || c == '[')
+                {
+                    if (stack_.size() + skipped_.size() >= options_.maxDepth)
+                    {
+                        fail("maximum depth exceeded");
+                    }
+                    ++index_;
+                    skipped_ += (c == '{') ? '}' : ']';
+                    eatWhitespace();
+                    if (peek() != skipped_.back())
+                    {
+                        if (c == '{') { skipKey(); }
+                        continue;
+                    }
+                    ++index_;
+                    skipped_.pop_back();
+                }
+                else if (c == '"') { skipString(); }
+                else if (c == 't' || c == 'f') { parseBoolean(); }
+                else if (c == 'n') { parseNull(); }
+                else if (c == '-' || (c >= '0' && c <= '9')) { scanNumber(); }
+                else if (c == '\0' && index_ == input_.size()) { fail("unexpected end of input"); }
+                else { fail("unexpected character"); }
+
+                for (;;)
+                {
+                    if (skipped_.empty())
+                    {
+                        return;
+                    }
+                    eatWhitespace();
+                    c = peek();
+                    if (c == ',')
+                    {
+                        ++index_;
+                        if (skipped_.back() == '}') { skipKey(); }
+                        break;
+                    }
+                    if (c != skipped_.back())
+                    {
+                        fail(skipped_.back() == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+                    }
+                    ++index_;
+                    skipped_.pop_back();
+                }
+            }
+        }
+
+        void skipKey()
+        {
+            eatWhitespace();
+            skipString();
+            eatWhitespace();
+            expect(':');
+        }
+
+        bool parseBoolean()
+        {
+            if (input_.substr(index_, 4) == "true")
+            {
+                index_ += 4;
+                return true;
+            }
+            if (input_.substr(index_, 5) == "false")
+            {
+                index_ += 5;
+                return false;
+            }
+            fail("unexpected character");
+        }
+
+        void parseNull()
+        {
+            if (input_.substr(index_, 4) != "null")
+            {
+                fail("unexpected character");
+            }
+            index_ += 4;
+        }
+    }; /* End of subclass Parser */
+
+    explicit Object(Type type = Type::Null) :
+        type_(type)
+    {}
+
+    Object(std::initializer_list<std::pair<Key, Object>> attributes) :
+            type_(Type::Object)
+    {
+        for (const auto& [key, value]: attributes)
+        {
+            ownMap()[key.str()] = value;
+        }
+    }
+
+    Object(std::initializer_list<Object> elements) :
+        type_(Type::Array)
+    {
+        ownVector().assign(elements.begin(), elements.end());
+    }
+
+    template <typename T>
+    Object(T value, typename std::enable_if<std::is_same<T, bool>::value>::type* = 0) :
+        type_(Type::Boolean), boolean_(value)
+    {}
+
+    template <typename T>
+    Object(T value, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type* = 0) :
+        type_(Type::Integer), integer_(value)
+    {}
+
+    template <typename T>
+    Object(T value, typename std::enable_if<std::is_floating_point<T>::value>::type* = 0) :
+        type_(Type::Double), double_(value)
+    {}
+
+    template <typename T>
+    Object(T value, typename std::enable_if<std::is_convertible<T, std::string>::value>::type* = 0) :
+        type_(Type::String), string_(value)
+    {}
+
+    Object(std::nullptr_t) :
+        type_(Type::Null )
+    {}
+
+    /**
+     * Copies share array and object contents by reference count; a shared container is duplicated
+     * only when one of its owners is mutated (copy-on-write). A node that has handed out a mutable
+     * reference to one of its children is copied one level deep instead, see makeShareable().
+     */
+    Object(const Object& other) :
+        type_(other.type_),
+        hash_(other.hash_),
+        raw_(other.raw_),
+        integer_(other.integer_),
+        double_(other.double_),
+        boolean_(other.boolean_),
+        string_(other.string_),
+        vector_(other.leaked_ ? copyOf(other.vector_) : other.vector_),
+        map_(other.leaked_ ? copyOf(other.map_) : other.map_)
+    {}
+
+    Object(Object&& other) = default;
+
+    Object& operator=(const Object& other)
+    {
+        if (this != &other)
+        {
+            *this = Object(other);
+        }
+        return *this;
+    }
+
+    Object& operator=(Object&& other) = default;
+
+    [[nodiscard]] bool isNull() const
+    {
+        return type_ == Type::Null;
+    }
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        if (isNull()) { return true; }
+        if (type_ == Type::Object) { return mapRef().size() == 0; }
+        if (type_ == Type::Array) { return vectorRef().size() == 0; }
+        return false;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        if (type_ == Type::Object)
+        {
+            return mapRef().size();
+        }
+        if (type_ == Type::Array)
+        {
+            return vectorRef().size();
+        }
+        throw Error("Invalid type");
+    }
+
+    [[nodiscard]] Type type() const
+    {
+        return type_;
+    }
+
+    bool toBoolean() const
+    {
+        if (type_ != Type::Boolean) { throw Error("Invalid type"); }
+        return boolean_;
+    }
+
+    std::int64_t toInteger() const
+    {
+        if (type_ != Type::Integer) { throw Error("Invalid type"); }
+        if (!raw_.isSet()) { return integer_; }
+        std::int64_t value;
+        if (!raw_.load(value))
+        {
+            if (std::from_chars(string_.data(), string_.data() + string_.size(), value).ec != std::errc())
+            {
+                throw Error("Number out of range");
+            }
+            raw_.store(value);
+        }
+        return value;
+    }
+
+    double toDouble() const
+    {
+        if (type_ != Type::Double) { throw Error("Invalid type"); }
+        if (!raw_.isSet()) { return double_; }
+        double value;
+        if (!raw_.load(value))
+        {
+            if (!detail::toDouble(string_.data(), string_.data() + string_.size(), value))
+            {
+                throw Error("Number out of range");
+            }
+            raw_.store(value);
+        }
+        return value;
+    }
+
+    std::string toString() const
+    {
+        if (type_ != Type::String) { throw Error("Invalid type"); }
+        return string_;
+    }
+
+    std::string_view asStringView() const
+    {
+        if (type_ != Type::String) { throw Error("Invalid type"); }
+        return string_;
+    }
+
+    const Object& at(std::string_view key) const
+    {
+        if (type_ != Type::Object) { throw Error("Invalid type"); }
+        auto it = mapRef().find(key);
+        if (it == mapRef().end()) { throw Error("Key not found"); }
+        return it->second;
+    }
+
+    const Object& at(std::size_t index) const
+    {
+        if (type_ != Type::Array) { throw Error("Invalid type"); }
+        if (index >= vectorRef().size()) { throw Error("Index out of range"); }
+        return vectorRef()[index];
+    }
+
+    [[nodiscard]] const_iterator find(std::string_view key) const
+    {
+        if (type_ != Type::Object) { throw Error("Invalid type"); }
+        return const_iterator(mapRef().find(key));
+    }
+
+    const_iterator begin() const
+    {
+        if (type_ == Type::Object) { return const_iterator(mapRef().begin()); }
+        if (type_ == Type::Array || type_ == Type::Null) { return const_iterator(vectorRef().begin()); }
+        throw Error("Invalid type");
+    }
+
+    const_iterator end() const
+    {
+        if (type_ == Type::Object) { return const_iterator(mapRef().end()); }
+        if (type_ == Type::Array || type_ == Type::Null) { return const_iterator(vectorRef().end()); }
+        throw Error("Invalid type");
+    }
+
+    [[nodiscard]] const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    [[nodiscard]] const_iterator cend() const
+    {
+        return end();
+    }
+
+    /**
+     * Mutable lookup: detaches shared contents first, so the result compares against end()
+     * of the same container and can be used to modify the member.
+     */
+    [[nodiscard]] iterator find(std::string_view key)
+    {
+        if (type_ != Type::Object) { throw Error("Invalid type"); }
+        hash_.reset();
+        leaked_ = true;
+        return iterator(ownMap().find(key));
+    }
+
+    /**
+     * Mutable iteration hands out references into this node, so it detaches shared contents
+     * first and then behaves like operator[] with respect to copies (see makeShareable()).
+     * Read-only loops over a shared tree should go through cbegin()/cend() or items() to keep
+     * the containers shared.
+     */
+    iterator begin()
+    {
+        if (type_ == Type::Null) { return iterator(Elements::iterator()); }
+        hash_.reset();
+        leaked_ = true;
+        if (type_ == Type::Object) { return iterator(ownMap().begin()); }
+        if (type_ == Type::Array) { return iterator(ownVector().begin()); }
+        throw Error("Invalid type");
+    }
+
+    iterator end()
+    {
+        if (type_ == Type::Null) { return iterator(Elements::iterator()); }
+        if (type_ == Type::Object) { return iterator(ownMap().end()); }
+        if (type_ == Type::Array) { return iterator(ownVector().end()); }
+        throw Error("Invalid type");
+    }
+
+    [[nodiscard]] Items items() const
+    {
+        return Items(begin(), end());
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        if (type_ == Type::Object) { return; }
+        if (type_ != Type::Array)
+        {
+            setType(Type::Array);
+        }
+        ownVector().reserve(capacity);
+    }
+
+    void clear()
+    {
+        hash_.reset();
+        raw_.reset();
+        type_ = Type::Null;
+        string_.clear();
+        vector_.reset();
+        map_.reset();
+        leaked_ = false;
+    }
+
+    void append(const Object& value)
+    {
+        if (type_ != Type::Array)
+        {
+            setType(Type::Array);
+        }
+        hash_.reset();
+        ownVector().push_back(value);
+    }
+
+    bool contains(std::string_view key) const
+    {
+        if (type_ != Type::Object) { throw Error("Invalid Type"); }
+        return mapRef().find(key) != mapRef().end();
+    }
+
+    void loads(const std::string& data)
+    {
+        if (data.empty())
+        {
+            clear();
+            return;
+        }
+        *this = Object::Parser().fromString(data);
+    }
+
+    std::string dumps(bool pretty = true, std::string ident = "") const;
+
+    template <typename T>
+    typename std::enable_if<std::is_same<T, bool>::value, Object&>::type operator=(T value)
+    {
+        setType(Type::Boolean);
+        boolean_ = value;
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, Object&>::type operator=(T value)
+    {
+        setType(Type::Integer);
+        integer_ = value;
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Object&>::type operator=(T value)
+    {
+        setType(Type::Double);
+        double_ = value;
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_convertible<T, std::string>::value, Object&>::type operator=(T value)
+    {
+        setType(Type::String);
+        string_ = std::string(value);
+        return *this;
+    }
+
+    Object& operator[](const std::string& key)
+    {
+        if (type_ != Type::Object)
+        {
+            setType(Type::Object);
+        }
+        hash_.reset();
+        leaked_ = true;
+        return ownMap()[key];
+    }
+
+    Object& operator[](std::uint32_t index)
+    {
+        if (type_ != Type::Array)
+        {
+            setType(Type::Array);
+        }
+        hash_.reset();
+        leaked_ = true;
+        auto& vector = ownVector();
+        if (index >= vector.size())
+        {
+            vector.resize(index + 1);
+        }
+        return vector[index];
+    }
+
+    /**
+     * Structural hash, computed lazily and cached on the node. A node that has handed out mutable
+     * references to its children cannot see them change, so it recomputes the hash on every call
+     * until makeShareable() is called on it.
+     */
+    [[nodiscard]] std::size_t hash() const
+    {
+        std::size_t result = leaked_ ? 0 : hash_.load();
+        if (result != 0) { return result; }
+
+        result = static_cast<std::size_t>(type_) + 1;
+        switch (type_) {
+            case Type::Boolean: combine(result, boolean_ ? 1 : 2); break;
+            case Type::Integer: combine(result, std::hash<std::int64_t>()(toInteger())); break;
+            case Type::Double:
+            {
+                double value = toDouble();
+                combine(result, std::hash<double>()(value == 0.0 ? 0.0 : value));
+                break;
+            }
+            case Type::String: combine(result, std::hash<std::string>()(string_)); break;
+            case Type::Array:
+                for (auto& object: vectorRef()) { combine(result, object.hash()); }
+                break;
+            case Type::Object:
+                for (auto& [key, object]: mapRef())
+                {
+                    combine(result, std::hash<std::string>()(key));
+                    combine(result, object.hash());
+                }
+                break;
+            default: break;
+        }
+        if (result == 0) { result = 1; }
+        if (!leaked_) { hash_.store(result); }
+        return result;
+    }
+
+    bool operator==(const Object& rhs) const
+    {
+        if (this == &rhs)
+        {
+            return true;
+        }
+        if (type_ != rhs.type_)
+        {
+            return false;
+        }
+        if (!leaked_ && !rhs.leaked_ && hash_.isSet() && rhs.hash_.isSet() && hash_.load() != rhs.hash_.load())
+        {
+            return false;
+        }
+
+        switch (type_) {
+            case Type::Boolean: return boolean_ == rhs.boolean_;
+            case Type::Integer: return toInteger() == rhs.toInteger();
+            case Type::Double: return toDouble() == rhs.toDouble();
+            case Type::String: return string_ == rhs.string_;
+            case Type::Array: return vector_ == rhs.vector_ || vectorRef() == rhs.vectorRef();
+            case Type::Object: return map_ == rhs.map_ || mapRef() == rhs.mapRef();
+            case Type::Null: return true;
+            default: return false;
+        }
+    }
+
+    bool operator!=(const Object& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    /**
+     * Declares that no reference previously obtained through a non-const accessor will be used to
+     * mutate this tree any more, so that subsequent copies share all of its containers.
+     */
+    Object& makeShareable()
+    {
+        if (!leaked_) { return *this; }
+        leaked_ = false;
+        if (vector_)
+        {
+            for (auto& object: ownVector()) { object.makeShareable(); }
+        }
+        if (map_)
+        {
+            for (auto& [key, object]: ownMap()) { object.makeShareable(); }
+        }
+        return *this;
+    }
+
+private:
+    friend class Writer;
+
+    class HashCache
+    {
+    public:
+        HashCache() = default;
+
+        HashCache(const HashCache& other) noexcept :
+            value_(other.load())
+        {}
+
+        HashCache& operator=(const HashCache& other) noexcept
+        {
+            store(other.load());
+            return *this;
+        }
+
+        [[nodiscard]] std::size_t load() const
+        {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+        void store(std::size_t value) const
+        {
+            value_.store(value, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool isSet() const
+        {
+            return load() != 0;
+        }
+
+        void reset()
+        {
+            store(0);
+        }
+    private:
+        mutable std::atomic<std::size_t> value_{0};
+    }; /* End of subclass HashCache */
+
+    /**
+     * Marks a number held as raw text in string_ and caches its value once decoded. Decoding may
+     * race between threads reading a shared node; they all store the same value.
+     */
+    class RawNumber
+    {
+    public:
+        RawNumber() = default;
+
+        RawNumber(const RawNumber& other) noexcept :
+            state_(other.state_.load(std::memory_order_acquire)),
+            bits_(other.bits_.load(std::memory_order_relaxed))
+        {}
+
+        RawNumber& operator=(const RawNumber& other) noexcept
+        {
+            auto state = other.state_.load(std::memory_order_acquire);
+            bits_.store(other.bits_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            state_.store(state, std::memory_order_release);
+            return *this;
+        }
+
+        [[nodiscard]] bool isSet() const
+        {
+            return state_.load(std::memory_order_relaxed) != State::None;
+        }
+
+        void set()
+        {
+            state_.store(State::Pending, std::memory_order_relaxed);
+        }
+
+        void reset()
+        {
+            state_.store(State::None, std::memory_order_relaxed);
+        }
+
+        template <typename T>
+        bool load(T& value) const
+        {
+            if (state_.load(std::memory_order_acquire) != State::Decoded) { return false; }
+            std::uint64_t bits = bits_.load(std::memory_order_relaxed);
+            std::memcpy(&value, &bits, sizeof(value));
+            return true;
+        }
+
+        template <typename T>
+        void store(T value) const
+        {
+            static_assert(sizeof(T) == sizeof(std::uint64_t));
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits_.store(bits, std::memory_order_relaxed);
+            state_.store(State::Decoded, std::memory_order_release);
+        }
+    private:
+        enum State : std::uint8_t
+        {
+            None,
+            Pending,
+            Decoded
+        }; /* End of enum State */
+
+        mutable std::atomic<std::uint8_t> state_{State::None};
+        mutable std::atomic<std::uint64_t> bits_{0};
+    }; /* End of subclass RawNumber */
+
+    Type type_;
+    HashCache hash_;
+    RawNumber raw_;
+    std::int64_t integer_{};
+    double double_{};
+    bool boolean_{};
+    std::string string_;
+    std::shared_ptr<Elements> vector_;
+    std::shared_ptr<Members> map_;
+    bool leaked_{};
+
+    void setType(Type type)
+    {
+        clear();
+        type_ = type;
+    }
+
+    const Elements& vectorRef() const
+    {
+        static const Elements empty;
+        return vector_ ? *vector_ : empty;
+    }
+
+    const Members& mapRef() const
+    {
+        static const Members empty;
+        return map_ ? *map_ : empty;
+    }
+
+    Elements& ownVector()
+    {
+        detach(vector_);
+        return *vector_;
+    }
+
+    Members& ownMap()
+    {
+        detach(map_);
+        return *map_;
+    }
+
+    template <typename T>
+    static void detach(std::shared_ptr<T>& container)
+    {
+        if (!container)
+        {
+            container = std::make_shared<T>();
+        }
+        else if (container.use_count() > 1)
+        {
+            container = std::make_shared<T>(*container);
+        }
+        else
+        {
+            // Pairs with the release in the other owners' reference drop before we write in place.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    }
+
+    template <typename T>
+    static std::shared_ptr<T> copyOf(const std::shared_ptr<T>& container)
+    {
+        return container ? std::make_shared<T>(*container) : nullptr;
+    }
+
+    static void combine(std::size_t& seed, std::size_t value)
+    {
+        seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+}; /* End of class Object */
+
+static_assert(std::is_nothrow_move_constructible_v<Object>, "containers of Object must move, not copy, on growth");
+static_assert(std::is_nothrow_move_assignable_v<Object>, "containers of Object must move, not copy, on growth");
+
+/**
+ * Streaming JSON writer emitting directly into a string, an output stream or a file descriptor,
+ * without building a tree first. Stream and descriptor output goes through a fixed-size buffer,
+ * so memory use does not depend on the size of the document. Pretty printing follows the layout
+ * of Object::dumps(). Misuse (e.g. a value without a key inside an object) throws in debug builds.
+ */
+class Writer
+{
+public:
+    static constexpr std::size_t bufferSize = 64 * 1024;
+
+    explicit Writer(std::string& output, bool pretty = false, std::string indent = "") :
+        out_(&output), pretty_(pretty), indent_(std::move(indent))
+    {}
+
+    explicit Writer(std::ostream& output, bool pretty = false, std::string indent = "") :
+        out_(&buffer_), stream_(&output), pretty_(pretty), indent_(std::move(indent))
+    {
+        buffer_.reserve(bufferSize);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    explicit Writer(int fd, bool pretty = false, std::string indent = "") :
+        out_(&buffer_), fd_(fd), pretty_(pretty), indent_(std::move(indent))
+    {
+        buffer_.reserve(bufferSize);
+    }
+#endif
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /**
+     * Flushes remaining output; call flush() explicitly to get write errors reported.
+     */
+    ~Writer()
+    {
+        try { flush(); } catch (...) {}
+    }
+
+    Writer& beginObject()
+    {
+        beginValue();
+        *out_ += '{';
+        if (pretty_) { *out_ += '\n'; }
+        stack_.push_back({true, true, false, childLevel()});
+        return *this;
+    }
+
+    Writer& endObject()
+    {
+        validate(!stack_.empty() && stack_.back().is_object, "endObject() outside of an object");
+        validate(stack_.empty() || !stack_.back().has_key, "endObject() after a key without a value");
+        if (stack_.empty()) { return *this; }
+        if (pretty_)
+        {
+            *out_ += '\n';
+            writeIndent(stack_.back().level);
+        }
+        *out_ += '}';
+        stack_.pop_back();
+        return endValue();
+    }
+
+    Writer& beginArray()
+    {
+        beginValue();
+        *out_ += '[';
+        stack_.push_back({false, true, false, childLevel()});
+        return *this;
+    }
+
+    Writer& endArray()
+    {
+        validate(!stack_.empty() && !stack_.back().is_object, "endArray() outside of an array");
+        if (stack_.empty()) { return *this; }
+        *out_ += ']';
+        stack_.pop_back();
+        return endValue();
+    }
+
+    Writer& key(std::string_view name)
+    {
+        validate(!stack_.empty() && stack_.back().is_object, "key() outside of an object");
+        validate(stack_.empty() || !stack_.back().has_key, "key() after a key without a value");
+        if (stack_.empty()) { return *this; }
+        Frame& frame = stack_.back();
+        if (!frame.first)
+        {
+            *out_ += ',';
+            if (pretty_) { *out_ += '\n'; }
+        }
+        frame.first = false;
+        frame.has_key = true;
+        if (pretty_) { writeIndent(frame.level + 1); }
+        detail::appendQuoted(*out_, name);
+        *out_ += pretty_ ? ": " : ":";
+        return *this;
+    }
+
+    Writer& value(std::nullptr_t)
+    {
+        beginValue();
+        *out_ += "null";
+        return endValue();
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_same<T, bool>::value, Writer&>::type value(T value)
+    {
+        beginValue();
+        *out_ += value ? "true" : "false";
+        return endValue();
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, Writer&>::type value(T value)
+    {
+        char buffer[24];
+        beginValue();
+        out_->append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+        return endValue();
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Writer&>::type value(T value)
+    {
+        char buffer[32];
+        beginValue();
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(value),
+                                    std::chars_format::general, 8);
+        out_->append(buffer, result.ptr);
+        return endValue();
+    }
+
+    Writer& value(std::string_view text)
+    {
+        beginValue();
+        detail::appendQuoted(*out_, text);
+        return endValue();
+    }
+
+    Writer& value(const char *text)
+    {
+        return value(std::string_view(text));
+    }
+
+    Writer& value(const std::string& text)
+    {
+        return value(std::string_view(text));
+    }
+
+    /**
+     * Writes a whole tree as the next value.
+     */
+    Writer& value(const Object& object)
+    {
+        switch (object.type()) {
+            case Type::Null: return value(nullptr);
+            case Type::Boolean: return value(object.toBoolean());
+            case Type::Integer:
+            case Type::Double:
+                if (object.raw_.isSet())
+                {
+                    beginValue();
+                    *out_ += object.string_;
+                    return endValue();
+                }
+                if (object.type() == Type::Integer) { return value(object.toInteger()); }
+                return value(object.toDouble());
+            case Type::String: return value(object.asStringView());
+            case Type::Array:
+                beginArray();
+                for (auto& element: object) { value(element); }
+                return endArray();
+            case Type::Object:
+                beginObject();
+                for (auto it = object.begin(); it != object.end(); ++it)
+                {
+                    key(it.key());
+                    value(*it);
+                }
+                return endObject();
+        }
+        throw Error("Invalid Type");
+    }
+
+    /**
+     * Tells whether a complete value has been written and all containers are closed.
+     */
+    [[nodiscard]] bool isComplete() const
+    {
+        return stack_.empty() && done_;
+    }
+
+    void flush()
+    {
+        if (out_ != &buffer_ || buffer_.empty())
+        {
+            return;
+        }
+        if (stream_)
+        {
+            stream_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            if (!*stream_)
+            {
+                throw Error("Write failed");
+            }
+        }
+#if defined(__unix__) || defined(__APPLE__)
+        else
+        {
+            std::size_t written = 0;
+            while (written < buffer_.size())
+            {
+                ssize_t result = ::write(fd_, buffer_.data() + written, buffer_.size() - written);
+                if (result < 0 && errno == EINTR) { continue; }
+                if (result < 0)
+                {
+                    throw Error("Write failed");
+                }
+                written += static_cast<std::size_t>(result);
+            }
+        }
+#endif
+        buffer_.clear();
+    }
+
+private:
+    struct Frame
+    {
+        bool is_object;
+        bool first;
+        bool has_key;
+        std::size_t level;
+    }; /* End of struct Frame */
+
+    std::string *out_;
+    std::string buffer_;
+    std::ostream *stream_{};
+    int fd_{-1};
+    bool pretty_;
+    bool done_{};
+    std::string indent_;
+    std::vector<Frame> stack_;
+
+    static void validate([[maybe_unused]] bool condition, [[maybe_unused]] const char *message)
+    {
+#ifndef NDEBUG
+        if (!condition)
+        {
+            throw Error(std::string("Invalid JSON structure: ") + message);
+        }
+#endif
+    }
+
+    [[nodiscard]] std::size_t childLevel() const
+    {
+        if (stack_.empty()) { return 0; }
+        return stack_.back().is_object ? stack_.back().level + 1 : stack_.back().level;
+    }
+
+    void writeIndent(std::size_t level)
+    {
+        *out_ += indent_;
+        out_->append(2 * level, ' ');
+    }
+
+    void beginValue()
+    {
+        if (stack_.empty())
+        {
+            validate(!done_, "more than one top-level value");
+            return;
+        }
+        Frame& frame = stack_.back();
+        if (frame.is_object)
+        {
+            validate(frame.has_key, "value inside an object without a key");
+            frame.has_key = false;
+            return;
+        }
+        if (!frame.first)
+        {
+            *out_ += pretty_ ? ", " : ",";
+        }
+        frame.first = false;
+    }
+
+    Writer& endValue()
+    {
+        if (stack_.empty())
+        {
+            done_ = true;
+        }
+        if (out_ == &buffer_ && buffer_.size() >= bufferSize)
+        {
+            flush();
+        }
+        return *this;
+    }
+}; /* End of class Writer */
+
+inline std::string Object::dumps(bool pretty, std::string ident) const
+{
+    std::string result;
+    Writer(result, pretty, std::move(ident)).value(*this);
+    return result;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Object& object)
+{
+    Writer(os, true).value(object);
+    return os;
+}
+
+namespace detail {
+
+/**
+ * Regular expression for the schema "pattern" keyword: ECMAScript syntax without backreferences
+ * and lookaround. The expression is compiled to a small instruction list that is run for all
+ * candidate paths in lockstep over the code points of the subject, so matching takes linear time
+ * and constant stack on input of any length.
+ */
+class Pattern
+{
+public:
+    explicit Pattern(std::string_view source) :
+        source_(source)
+    {
+        std::size_t root = parseAlternation(0);
+        if (position_ != source_.size()) { fail("Invalid schema pattern"); }
+        emit(root);
+        code_.push_back({Op::Match, 0, 0});
+        anchored_ = (code_.front().op == Op::Begin);
+        terms_.clear();
+        source_ = {};
+    }
+
+    /**
+     * Tells whether the expression matches anywhere in text, like RegExp.prototype.test().
+     */
+    [[nodiscard]] bool search(std::string_view text) const
+    {
+        std::vector<std::size_t> current, next, pending;
+        std::vector<std::size_t> marks(code_.size(), 0);
+        std::size_t generation = 1;
+
+        auto follow = [&](std::vector<std::size_t>& list, std::size_t start, const Context& at) {
+            pending.push_back(start);
+            while (!pending.empty())
+            {
+                std::size_t pc = pending.back();
+                pending.pop_back();
+                if (marks[pc] == generation) { continue; }
+                marks[pc] = generation;
+                const Instruction& instruction = code_[pc];
+                switch (instruction.op) {
+                    case Op::Set: list.push_back(pc); break;
+                    case Op::Match: pending.clear(); return true;
+                    case Op::Jump: pending.push_back(instruction.x); break;
+                    case Op::Split:
+                        pending.push_back(instruction.y);
+                        pending.push_back(instruction.x);
+                        break;
+                    case Op::Begin: if (at.offset == 0) { pending.push_back(pc + 1); } break;
+                    case Op::End: if (at.offset == text.size()) { pending.push_back(pc + 1); } break;
+                    case Op::WordBoundary:
+                        if (isWord(at.previous) != isWord(at.next)) { pending.push_back(pc + 1); }
+                        break;
+                    case Op::NotWordBoundary:
+                        if (isWord(at.previous) == isWord(at.next)) { pending.push_back(pc + 1); }
+                        break;
+                }
+            }
+            return false;
+        };
+
+        std::size_t following = 0;
+        Context at{0, none, decode(text, following)};
+        for (;;)
+        {
+            if ((at.offset == 0 || !anchored_) && follow(current, 0, at)) { return true; }
+            if (at.offset == text.size() || (anchored_ && current.empty())) { return false; }
+
+            ++generation;
+            next.clear();
+            std::size_t offset = following;
+            Context then{offset, at.next, decode(text, following)};
+            for (std::size_t pc: current)
+            {
+                if (contains(sets_[code_[pc].x], at.next) && follow(next, pc + 1, then)) { return true; }
+            }
+            current.swap(next);
+            at = then;
+        }
+    }
+
+private:
+    static constexpr std::size_t maxInstructions = 1 << 16;
+    static constexpr std::size_t maxNesting = 256;
+    static constexpr std::size_t maxCount = 1000;
+    static constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+    static constexpr char32_t none = 0xFFFFFFFF;
+
+    using Ranges = std::vector<std::pair<char32_t, char32_t>>;
+
+    enum class Op : std::uint8_t
+    {
+        Set,
+        Split,
+        Jump,
+        Begin,
+        End,
+        WordBoundary,
+        NotWordBoundary,
+        Match
+    }; /* End of enum Op */
+
+    /**
+     * Set: x is the index of the character set. Split: continue at both x and y. Jump: continue at x.
+     */
+    struct Instruction
+    {
+        Op op;
+        std::size_t x;
+        std::size_t y;
+    }; /* End of struct Instruction */
+
+    enum class Kind : std::uint8_t
+    {
+        Set,
+        Begin,
+        End,
+        WordBoundary,
+        NotWordBoundary,
+        Sequence,
+        Alternation,
+        Repeat
+    }; /* End of enum Kind */
+
+    struct Term
+    {
+        Kind kind;
+        std::size_t set;
+        std::size_t min;
+        std::size_t max;
+        std::vector<std::size_t> children;
+    }; /* End of struct Term */
+
+    struct Context
+    {
+        std::size_t offset;
+        char32_t previous;
+        char32_t next;
+    }; /* End of struct Context */
+
+    std::string_view source_;
+    std::size_t position_{};
+    std::vector<Term> terms_;
+    std::vector<Ranges> sets_;
+    std::vector<Instruction> code_;
+    bool anchored_{};
+
+    [[noreturn]] static void fail(const char *message)
+    {
+        throw Error(message);
+    }
+
+    /**
+     * Decodes the code point at offset and advances past it; malformed bytes decode as U+FFFD.
+     * Returns none at the end of text.
+     */
+    static char32_t decode(std::string_view text, std::size_t& offset)
+    {
+        if (offset >= text.size()) { return none; }
+        auto byte = [&](std::size_t i) { return static_cast<char32_t>(static_cast<unsigned char>(text[offset + i])); };
+        std::size_t length = utf8SequenceLength(text.data() + offset, text.size() - offset);
+        char32_t c;
+        switch (length) {
+            case 1: c = byte(0); break;
+            case 2: c = ((byte(0) & 0x1F) << 6) | (byte(1) & 0x3F); break;
+            case 3: c = ((byte(0) & 0x0F) << 12) | ((byte(1) & 0x3F) << 6) | (byte(2) & 0x3F); break;
+            case 4:
+                c = ((byte(0) & 0x07) << 18) | ((byte(1) & 0x3F) << 12) | ((byte(2) & 0x3F) << 6) | (byte(3) & 0x3F);
+                break;
+            default: c = 0xFFFD; length = 1; break;
+        }
+        offset += length;
+        return c;
+    }
+
+    static bool isWord(char32_t c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+    }
+
+    static bool contains(const Ranges& ranges, char32_t c)
+    {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), c,
+                                   [](char32_t value, const auto& range) { return value < range.first; });
+        return it != ranges.begin() && c <= std::prev(it)->second;
+    }
+
+    static Ranges normalize(Ranges ranges)
+    {
+        std::sort(ranges.begin(), ranges.end());
+        Ranges result;
+        for (auto& range: ranges)
+        {
+            if (!result.empty() && range.first <= result.back().second + 1)
+            {
+                result.back().second = std::max(result.back().second, range.second);
+            }
+            else { result.push_back(range); }
+        }
+        return result;
+    }
+
+    static Ranges complement(const Ranges& ranges)
+    {
+        Ranges result;
+        char32_t first = 0;
+        for (auto& range: normalize(ranges))
+        {
+            if (range.first > first) { result.emplace_back(first, range.first - 1); }
+            first = range.second + 1;
+        }
+        if (first <= 0x10FFFF) { result.emplace_back(first, 0x10FFFF); }
+        return result;
+    }
+
+    /**
+     * Appends the ranges of a \d, \D, \w, \W, \s or \S escape, or returns false for other letters.
+     */
+    static bool classEscape(char letter, Ranges& ranges)
+    {
+        static const Ranges digits{{'0', '9'}};
+        static const Ranges word{{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+        static const Ranges space{{'\t', '\r'}, {' ', ' '}, {0xA0, 0xA0}, {0x1680, 0x1680}, {0x2000, 0x200A},
+                                  {0x2028, 0x2029}, {0x202F, 0x202F}, {0x205F, 0x205F}, {0x3000, 0x3000},
+                                  {0xFEFF, 0xFEFF}};
+        const Ranges *base;
+        switch (letter) {
+            case 'd': case 'D': base = &digits; break;
+            case 'w': case 'W': base = &word; break;
+            case 's': case 'S': base = &space; break;
+            default: return false;
+        }
+        Ranges added = (letter >= 'a') ? *base : complement(*base);
+        ranges.insert(ranges.end(), added.begin(), added.end());
+        return true;
+    }
+
+    std::size_t add(Term term)
+    {
+        terms_.push_back(std::move(term));
+        return terms_.size() - 1;
+    }
+
+    std::size_t addSet(Ranges ranges)
+    {
+        sets_.push_back(normalize(std::move(ranges)));
+        return add({Kind::Set, sets_.size() - 1, 0, 0, {}});
+    }
+
+    bool atEnd() const
+    {
+        return position_ >= source_.size();
+    }
+
+    std::size_t parseAlternation(std::size_t depth)
+    {
+        if (depth > maxNesting) { fail("Invalid schema pattern"); }
+        std::vector<std::size_t> branches{parseSequence(depth)};
+        while (!atEnd() && source_[position_] == '|')
+        {
+            ++position_;
+            branches.push_back(parseSequence(depth));
+        }
+        if (branches.size() == 1) { return branches.front(); }
+        return add({Kind::Alternation, 0, 0, 0, std::move(branches)});
+    }
+
+    std::size_t parseSequence(std::size_t depth)
+    {
+        std::vector<std::size_t> items;
+        while (!atEnd() && source_[position_] != '|' && source_[position_] != ')')
+        {
+            items.push_back(parseQuantifier(parseAtom(depth)));
+        }
+        return add({Kind::Sequence, 0, 0, 0, std::move(items)});
+    }
+
+    /**
+     * Parses "{n}", "{n,}" or "{n,m}" at the current position. Anything else is not a quantifier
+     * and leaves the position unchanged, so that the brace is taken literally.
+     */
+    bool parseBraces(std::size_t& min, std::size_t& max)
+    {
+        std::size_t position = position_ + 1;
+        auto number = [&](std::size_t& value) {
+            std::size_t start = position;
+            value = 0;
+            for (; position < source_.size() && source_[position] >= '0' && source_[position] <= '9'; ++position)
+            {
+                value = std::min(value * 10 + (source_[position] - '0'), maxCount + 1);
+            }
+            return position > start;
+        };
+        if (!number(min)) { return false; }
+        max = min;
+        if (position < source_.size() && source_[position] == ',')
+        {
+            ++position;
+            if (!number(max)) { max = unbounded; }
+        }
+        if (position >= source_.size() || source_[position] != '}') { return false; }
+        position_ = position + 1;
+        return true;
+    }
+
+    std::size_t parseQuantifier(std::size_t atom)
+    {
+        if (atEnd()) { return atom; }
+        std::size_t min, max;
+        char c = source_[position_];
+        if (c == '*') { min = 0; max = unbounded; ++position_; }
+        else if (c == '+') { min = 1; max = unbounded; ++position_; }
+        else if (c == '?') { min = 0; max = 1; ++position_; }
+        else if (c != '{' || !parseBraces(min, max)) { return atom; }
+        if (!atEnd() && source_[position_] == '?') { ++position_; }
+
+        Kind kind = terms_[atom].kind;
+        if (kind == Kind::Begin || kind == Kind::End || kind == Kind::WordBoundary || kind == Kind::NotWordBoundary)
+        {
+            fail("Invalid schema pattern");
+        }
+        if (min > maxCount || (max != unbounded && (max > maxCount || max < min)))
+        {
+            fail("Invalid schema pattern");
+        }
+        return add({Kind::Repeat, 0, min, max, {atom}});
+    }
+
+    std::size_t parseAtom(std::size_t depth)
+    {
+        char c = source_[position_];
+        switch (c) {
+            case '(':
+            {
+                ++position_;
+                if (source_.substr(position_, 2) == "?:") { position_ += 2; }
+                else if (source_.substr(position_, 2) == "?<" && position_ + 2 < source_.size()
+                         && source_[position_ + 2] != '=' && source_[position_ + 2] != '!')
+                {
+                    position_ = source_.find('>', position_);
+                    if (position_ == std::string_view::npos) { fail("Invalid schema pattern"); }
+                    ++position_;
+                }
+                else if (!atEnd() && source_[position_] == '?') { fail("Unsupported schema pattern"); }
+                std::size_t inner = parseAlternation(depth + 1);
+                if (atEnd() || source_[position_] != ')') { fail("Invalid schema pattern"); }
+                ++position_;
+                return inner;
+            }
+            case '*':
+            case '+':
+            case '?':
+                fail("Invalid schema pattern");
+            case '{':
+            {
+                std::size_t min, max;
+                if (parseBraces(min, max)) { fail("Invalid schema pattern"); }
+                break;
+            }
+            case '[': return parseClass();
+            case '.': ++position_; return addSet(complement({{'\n', '\n'}, {'\r', '\r'}, {0x2028, 0x2029}}));
+            case '^': ++position_; return add({Kind::Begin, 0, 0, 0, {}});
+            case '$': ++position_; return add({Kind::End, 0, 0, 0, {}});
+            case '\\':
+            {
+                ++position_;
+                if (atEnd()) { fail("Invalid schema pattern"); }
+                char letter = source_[position_];
+                if (letter == 'b' || letter == 'B')
+                {
+                    ++position_;
+                    return add({(letter == 'b') ? Kind::WordBoundary : Kind::NotWordBoundary, 0, 0, 0, {}});
+                }
+                Ranges ranges;
+                if (classEscape(letter, ranges))
+                {
+                    ++position_;
+                    return addSet(std::move(ranges));
+                }
+                char32_t value = parseEscape();
+                return addSet({{value, value}});
+            }
+            default: break;
+        }
+        char32_t value = decode(source_, position_);
+        return addSet({{value, value}});
+    }
+
+    /**
+     * Parses the character escape following a backslash and returns its code point.
+     */
+    char32_t parseEscape()
+    {
+        auto hex = [this](std::size_t digits) {
+            char32_t value = 0;
+            for (std::size_t i = 0; i < digits; ++i, ++position_)
+            {
+                char c = atEnd() ? '\0' : source_[position_];
+                value <<= 4;
+                if (c >= '0' && c <= '9') { value |= c - '0'; }
+                else if (c >= 'a' && c <= 'f') { value |= c - 'a' + 10; }
+                else if (c >= 'A' && c <= 'F') { value |= c - 'A' + 10; }
+                else { fail("Invalid schema pattern"); }
+            }
+            return value;
+        };
+
+        char letter = source_[position_++];
+        switch (letter) {
+            case 't': return '\t';
+            case 'n': return '\n';
+            case 'v': return '\v';
+            case 'f': return '\f';
+            case 'r': return '\r';
+            case 'x': return hex(2);
+            case 'u': return hex(4);
+            case '0':
+                if (!atEnd() && source_[position_] >= '0' && source_[position_] <= '9') { break; }
+                return 0;
+            case 'c':
+                if (atEnd() || !std::isalpha(static_cast<unsigned char>(source_[position_]))) { break; }
+                return source_[position_++] % 32;
+            default:
+                if (std::ispunct(static_cast<unsigned char>(letter))) { return static_cast<unsigned char>(letter); }
+                if (letter >= '1' && letter <= '9') { fail("Unsupported schema pattern"); }
+                break;
+        }
+        fail("Invalid schema pattern");
+    }
+
+    /**
+     * Parses one class member into value, or appends a class escape to ranges and returns false.
+     */
+    bool parseClassAtom(Ranges& ranges, char32_t& value)
+    {
+        if (source_[position_] != '\\')
+        {
+            value = decode(source_, position_);
+            return true;
+        }
+        ++position_;
+        if (atEnd()) { fail("Invalid schema pattern"); }
+        if (classEscape(source_[position_], ranges))
+        {
+            ++position_;
+            return false;
+        }
+        if (source_[position_] == 'b')
+        {
+            ++position_;
+            value = '\b';
+            return true;
+        }
+        if (source_[position_] == '-')
+        {
+            ++position_;
+            value = '-';
+            return true;
+        }
+        value = parseEscape();
+        return true;
+    }
+
+    std::size_t parseClass()
+    {
+        ++position_;
+        bool negated = !atEnd() && source_[position_] == '^';
+        if (negated) { ++position_; }
+        Ranges ranges;
+        for (;;)
+        {
+            if (atEnd()) { fail("Invalid schema pattern"); }
+            if (source_[position_] == ']')
+            {
+                ++position_;
+                break;
+            }
+            char32_t low;
+            if (!parseClassAtom(ranges, low)) { continue; }
+            if (position_ + 1 < source_.size() && source_[position_] == '-' && source_[position_ + 1] != ']')
+            {
+                ++position_;
+                char32_t high;
+                if (!parseClassAtom(ranges, high) || high < low) { fail("Invalid schema pattern"); }
+                ranges.emplace_back(low, high);
+            }
+            else { ranges.emplace_back(low, low); }
+        }
+        return addSet(negated ? complement(ranges) : std::move(ranges));
+    }
+
+    void emit(std::size_t index)
+    {
+        if (code_.size() > maxInstructions) { fail("Schema pattern too large"); }
+        const Term& term = terms_[index];
+        switch (term.kind) {
+            case Kind::Set: code_.push_back({Op::Set, term.set, 0}); break;
+            case Kind::Begin: code_.push_back({Op::Begin, 0, 0}); break;
+            case Kind::End: code_.push_back({Op::End, 0, 0}); break;
+            case Kind::WordBoundary: code_.push_back({Op::WordBoundary, 0, 0}); break;
+            case Kind::NotWordBoundary: code_.push_back({Op::NotWordBoundary, 0, 0}); break;
+            case Kind::Sequence:
+                for (std::size_t child: term.children) { emit(child); }
+                break;
+            case Kind::Alternation:
+            {
+                std::vector<std::size_t> jumps;
+                for (std::size_t i = 0; i + 1 < term.children.size(); ++i)
                 {
-                    get(); // consume ','
+                    std::size_t split = code_.size();
+                    code_.push_back({Op::Split, split + 1, 0});
+                    emit(term.children[i]);
+                    jumps.push_back(code_.size());
+                    code_.push_back({Op::Jump, 0, 0});
+                    code_[split].y = code_.size();
                 }
-                else if (peek() == ']')
+                emit(term.children.back());
+                for (std::size_t jump: jumps) { code_[jump].x = code_.size(); }
+                break;
+            }
+            case Kind::Repeat:
+            {
+                for (std::size_t i = 0; i < term.min; ++i) { emit(term.children.front()); }
+                if (term.max == unbounded)
                 {
-                    get(); // consume ']'
+                    std::size_t loop = code_.size();
+                    code_.push_back({Op::Split, loop + 1, 0});
+                    emit(term.children.front());
+                    code_.push_back({Op::Jump, loop, 0});
+                    code_[loop].y = code_.size();
                     break;
                 }
-                else
+                std::vector<std::size_t> splits;
+                for (std::size_t i = term.min; i < term.max; ++i)
                 {
-                    throw Error("Invalid JSON");
+                    splits.push_back(code_.size());
+                    code_.push_back({Op::Split, code_.size() + 1, 0});
+                    emit(term.children.front());
                 }
+                for (std::size_t split: splits) { code_[split].y = code_.size(); }
+                break;
+            }
+        }
+    }
+}; /* End of class Pattern */
+
+} /* End of namespace detail */
+
+/**
+ * JSON Schema compiled once into a flat table of nodes. Supported keywords: type, enum, const,
+ * minimum, maximum, exclusiveMinimum, exclusiveMaximum, minLength, maxLength, pattern (see
+ * detail::Pattern), items, minItems, maxItems, properties, additionalProperties, required,
+ * minProperties and maxProperties; annotations are ignored and any other keyword is rejected at
+ * compile time.
+ * A schema validates a parsed tree, or a document while it is parsed (see Object::Parser).
+ */
+class Schema
+{
+public:
+    explicit Schema(const Object& schema)
+    {
+        nodes_.emplace_back();
+        root_ = compile(schema);
+    }
+
+    [[nodiscard]] bool isValid(const Object& value) const
+    {
+        std::string error;
+        return check(root_, value, error);
+    }
+
+    void validate(const Object& value) const
+    {
+        std::string error;
+        if (!check(root_, value, error))
+        {
+            throw Error("Schema violation at " + error);
+        }
+    }
+
+private:
+    friend class Object::Parser;
+
+    static constexpr std::size_t any = 0;
+    static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+    static constexpr unsigned allTypes = 0x7F;
+
+    struct Node
+    {
+        unsigned types{allTypes};
+        bool integral{};
+        bool has_enum{};
+        std::vector<Object> enumeration;
+        double minimum{-std::numeric_limits<double>::infinity()};
+        double maximum{std::numeric_limits<double>::infinity()};
+        double exclusive_minimum{-std::numeric_limits<double>::infinity()};
+        double exclusive_maximum{std::numeric_limits<double>::infinity()};
+        std::size_t min_length{};
+        std::size_t max_length{std::numeric_limits<std::size_t>::max()};
+        std::optional<detail::Pattern> pattern;
+        std::size_t items{any};
+        std::size_t min_items{};
+        std::size_t max_items{std::numeric_limits<std::size_t>::max()};
+        std::size_t min_properties{};
+        std::size_t max_properties{std::numeric_limits<std::size_t>::max()};
+        std::map<std::string, std::size_t, std::less<>> properties;
+        std::size_t additional{any};
+        std::vector<std::string> required;
+    }; /* End of struct Node */
+
+    std::vector<Node> nodes_;
+    std::size_t root_{};
+
+    static unsigned bit(Type type)
+    {
+        return 1u << static_cast<unsigned>(type);
+    }
+
+    static std::size_t toSize(const Object& value)
+    {
+        if (value.type() != Type::Integer || value.toInteger() < 0) { throw Error("Invalid schema"); }
+        return static_cast<std::size_t>(value.toInteger());
+    }
+
+    static std::string_view toText(const Object& value)
+    {
+        if (value.type() != Type::String) { throw Error("Invalid schema"); }
+        return value.asStringView();
+    }
+
+    /**
+     * Escapes a member name as a JSON pointer reference token (RFC 6901).
+     */
+    static std::string pointerToken(std::string_view key)
+    {
+        std::string token = "/";
+        for (char c: key)
+        {
+            if (c == '~') { token += "~0"; }
+            else if (c == '/') { token += "~1"; }
+            else { token += c; }
+        }
+        return token;
+    }
+
+    static double toNumber(const Object& value)
+    {
+        if (value.type() == Type::Integer) { return static_cast<double>(value.toInteger()); }
+        if (value.type() == Type::Double) { return value.toDouble(); }
+        throw Error("Invalid schema");
+    }
+
+    std::size_t compile(const Object& schema)
+    {
+        if (schema.type() == Type::Boolean)
+        {
+            if (schema.toBoolean()) { return any; }
+            nodes_.emplace_back();
+            nodes_.back().types = 0;
+            return nodes_.size() - 1;
+        }
+        if (schema.type() != Type::Object) { throw Error("Invalid schema"); }
+
+        Node node;
+        for (auto it = schema.begin(); it != schema.end(); ++it)
+        {
+            std::string_view keyword = it.key();
+            const Object& value = *it;
+            if (keyword == "type")
+            {
+                node.types = 0;
+                if (value.type() == Type::String) { addType(node, toText(value)); }
+                else if (value.type() == Type::Array)
+                {
+                    for (auto& type: value) { addType(node, toText(type)); }
+                }
+                else { throw Error("Invalid schema"); }
+            }
+            else if (keyword == "enum" || keyword == "const")
+            {
+                if (keyword == "enum" && value.type() != Type::Array) { throw Error("Invalid schema"); }
+                node.has_enum = true;
+                if (keyword == "const") { node.enumeration.push_back(value); }
+                else { node.enumeration.assign(value.begin(), value.end()); }
+            }
+            else if (keyword == "minimum") { node.minimum = toNumber(value); }
+            else if (keyword == "maximum") { node.maximum = toNumber(value); }
+            else if (keyword == "exclusiveMinimum") { node.exclusive_minimum = toNumber(value); }
+            else if (keyword == "exclusiveMaximum") { node.exclusive_maximum = toNumber(value); }
+            else if (keyword == "minLength") { node.min_length = toSize(value); }
+            else if (keyword == "maxLength") { node.max_length = toSize(value); }
+            else if (keyword == "pattern") { node.pattern.emplace(toText(value)); }
+            else if (keyword == "items") { node.items = compile(value); }
+            else if (keyword == "minItems") { node.min_items = toSize(value); }
+            else if (keyword == "maxItems") { node.max_items = toSize(value); }
+            else if (keyword == "minProperties") { node.min_properties = toSize(value); }
+            else if (keyword == "maxProperties") { node.max_properties = toSize(value); }
+            else if (keyword == "properties")
+            {
+                if (value.type() != Type::Object) { throw Error("Invalid schema"); }
+                for (auto property = value.begin(); property != value.end(); ++property)
+                {
+                    std::size_t index = compile(*property);
+                    node.properties.emplace(property.key(), index);
+                }
+            }
+            else if (keyword == "additionalProperties")
+            {
+                node.additional = compile(value);
+                if (value.type() == Type::Boolean && !value.toBoolean()) { node.additional = none; }
+            }
+            else if (keyword == "required")
+            {
+                if (value.type() != Type::Array) { throw Error("Invalid schema"); }
+                for (auto& name: value) { node.required.emplace_back(toText(name)); }
+            }
+            else if (keyword != "$schema" && keyword != "$id" && keyword != "title" && keyword != "description"
+                     && keyword != "default" && keyword != "examples" && keyword != "$comment")
+            {
+                throw Error("Unsupported schema keyword: " + std::string(keyword));
+            }
+        }
+        nodes_.push_back(std::move(node));
+        return nodes_.size() - 1;
+    }
+
+    /**
+     * Equality as JSON Schema defines it for enum and const: like Object::operator==, except that
+     * numbers compare by value, so 2 and 2.0 are equal at any depth.
+     */
+    static bool equal(const Object& lhs, const Object& rhs)
+    {
+        Type left = lhs.type(), right = rhs.type();
+        if (left == Type::Double && right == Type::Integer) { return equal(rhs, lhs); }
+        if (left == Type::Integer && right == Type::Double)
+        {
+            double number = rhs.toDouble();
+            return number >= -0x1p63 && number < 0x1p63 && std::trunc(number) == number
+                   && static_cast<std::int64_t>(number) == lhs.toInteger();
+        }
+        if (left != right) { return false; }
+        if (left == Type::Array)
+        {
+            return lhs.size() == rhs.size() && std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin(), equal);
+        }
+        if (left == Type::Object)
+        {
+            if (lhs.size() != rhs.size()) { return false; }
+            for (auto it = lhs.cbegin(); it != lhs.cend(); ++it)
+            {
+                auto other = rhs.find(it.key());
+                if (other == rhs.cend() || !equal(*it, *other)) { return false; }
+            }
+            return true;
+        }
+        return lhs == rhs;
+    }
+
+    static void addType(Node& node, std::string_view name)
+    {
+        if (name == "null") { node.types |= bit(Type::Null); }
+        else if (name == "boolean") { node.types |= bit(Type::Boolean); }
+        else if (name == "object") { node.types |= bit(Type::Object); }
+        else if (name == "array") { node.types |= bit(Type::Array); }
+        else if (name == "string") { node.types |= bit(Type::String); }
+        else if (name == "number") { node.types |= bit(Type::Integer) | bit(Type::Double); }
+        else if (name == "integer")
+        {
+            node.types |= bit(Type::Integer);
+            node.integral = true;
+        }
+        else { throw Error("Invalid schema type: " + std::string(name)); }
+    }
+
+    [[nodiscard]] bool allows(std::size_t index, Type type) const
+    {
+        const Node& node = nodes_[index];
+        return (node.types & bit(type)) || (type == Type::Double && node.integral);
+    }
+
+    /**
+     * Checks the constraints of one node against value, without descending into its elements
+     * or members. Returns the reason of a violation, or nullptr.
+     */
+    const char *checkNode(std::size_t index, const Object& value, std::string& missing) const
+    {
+        const Node& node = nodes_[index];
+        Type type = value.type();
+        if (!(node.types & bit(type)))
+        {
+            if (!(type == Type::Double && node.integral && std::trunc(value.toDouble()) == value.toDouble()))
+            {
+                return "unexpected type";
             }
-            return result;
         }
-
-        Object parseString()
+        auto matches = [&value](const Object& allowed) { return equal(allowed, value); };
+        if (node.has_enum && std::none_of(node.enumeration.begin(), node.enumeration.end(), matches))
         {
-            std::string value;
-            get(); // consume '"'
-            for (;;)
+            return "value not allowed";
+        }
+        if (type == Type::Integer || type == Type::Double)
+        {
+            double number = (type == Type::Integer) ? static_cast<double>(value.toInteger()) : value.toDouble();
+            if (number < node.minimum || number <= node.exclusive_minimum)
             {
-                char c = get();
-                if (c == '"') { break; }
-                value += c;
+                return "number too small";
+            }
+            if (number > node.maximum || number >= node.exclusive_maximum)
+            {
+                return "number too large";
             }
-            return value;
         }
-
-        Object parseNumber()
+        else if (type == Type::String)
         {
-            bool is_float = false;
-            std::string value;
-            while (std::isdigit(peek()) || peek() == '.' || peek() == '-' || std::tolower(peek()) == 'e')
+            std::string_view text = value.asStringView();
+            std::size_t length = 0;
+            for (char c: text)
             {
-                char c = get();
-                if (c == '.' || std::tolower(peek()) == 'e') { is_float = true; }
-                value += c;
+                if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) { ++length; }
             }
-            if (is_float)
+            if (length < node.min_length) { return "string too short"; }
+            if (length > node.max_length) { return "string too long"; }
+            if (node.pattern && !node.pattern->search(text))
             {
-                return std::stod(value);
+                return "string does not match pattern";
             }
-            return std::stol(value);
         }
-
-        Object parseBoolean()
+        else if (type == Type::Array)
         {
-            if (peek() == 't')
+            if (value.size() < node.min_items) { return "too few items"; }
+            if (value.size() > node.max_items) { return "too many items"; }
+        }
+        else if (type == Type::Object)
+        {
+            if (value.size() < node.min_properties) { return "too few members"; }
+            if (value.size() > node.max_properties) { return "too many members"; }
+            for (auto& name: node.required)
             {
-                if (input_.substr(index_, 4) == "true")
+                if (!value.contains(name))
                 {
-                    index_ += 4;
-                    return true;
+                    missing = name;
+                    return "missing required member";
                 }
-                throw Error("Invalid JSON");
             }
-            if (peek() == 'f')
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] std::size_t member(std::size_t index, std::string_view key) const
+    {
+        const Node& node = nodes_[index];
+        auto it = node.properties.find(key);
+        return (it != node.properties.end()) ? it->second : node.additional;
+    }
+
+    [[nodiscard]] std::size_t element(std::size_t index) const
+    {
+        return nodes_[index].items;
+    }
+
+    /**
+     * Validates value against a node recursively. On failure error holds a JSON pointer to the
+     * offending value followed by the reason; the path is only built while unwinding.
+     */
+    bool check(std::size_t index, const Object& value, std::string& error) const
+    {
+        std::string missing;
+        if (const char *reason = checkNode(index, value, missing))
+        {
+            error = std::string(": ") + reason;
+            if (!missing.empty()) { error += " '" + missing + "'"; }
+            return false;
+        }
+        if (value.type() == Type::Array)
+        {
+            std::size_t position = 0;
+            for (auto& child: value)
             {
-                if (input_.substr(index_, 5) == "false")
+                if (!check(element(index), child, error))
                 {
-                    index_ += 5;
+                    error = "/" + std::to_string(position) + error;
                     return false;
                 }
-                throw Error("Invalid JSON");
+                ++position;
             }
-            throw Error("Invalid JSON");
         }
-
-        Object parseNull()
+        else if (value.type() == Type::Object)
         {
-            if (input_.substr(index_, 4) == "null")
+            for (auto it = value.begin(); it != value.end(); ++it)
             {
-                index_ += 4;
-                return nullptr;
+                std::size_t child = member(index, it.key());
+                if (child == none)
+                {
+                    error = pointerToken(it.key()) + ": unexpected member";
+                    return false;
+                }
+                if (!check(child, *it, error))
+                {
+                    error = pointerToken(it.key()) + error;
+                    return false;
+                }
             }
-            throw Error("Invalid JSON");
         }
-    }; /* End of subclass Parser */
+        return true;
+    }
+}; /* End of class Schema */
 
-    explicit Object(Type type = Type::Null) :
-        type_(type)
-    {}
+inline void Object::Parser::startSchema(const Schema *schema)
+{
+    schema_ = schema;
+    schemaNode_ = schema ? schema->root_ : Schema::any;
+}
 
-    Object(std::initializer_list<std::pair<Key, Object>> attributes) :
-            type_(Type::Object)
+inline void Object::Parser::checkSchemaType(Type type) const
+{
+    if (schema_ && !schema_->allows(schemaNode_, type))
     {
-        for (const auto& [key, value]: attributes)
-        {
-            map_[key.str()] = value;
-        }
+        throw Error("Schema violation: unexpected type", index_);
     }
+}
 
-    Object(std::initializer_list<Object> elements) :
-        type_(Type::Array)
+inline void Object::Parser::checkSchema(std::size_t node, const Object& value, std::size_t offset) const
+{
+    if (!schema_ || node == Schema::any)
     {
-        vector_.insert(vector_.end(), elements.begin(), elements.end());
+        return;
     }
+    std::string missing;
+    if (const char *reason = schema_->checkNode(node, value, missing))
+    {
+        std::string message = std::string("Schema violation: ") + reason;
+        if (!missing.empty()) { message += " '" + missing + "'"; }
+        throw Error(message, offset);
+    }
+}
 
-    template <typename T>
-    Object(T value, typename std::enable_if<std::is_same<T, bool>::value>::type* = 0) :
-        type_(Type::Boolean), boolean_(value)
-    {}
-
-    template <typename T>
-    Object(T value, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type* = 0) :
-        type_(Type::Integer), integer_(value)
-    {}
-
-    template <typename T>
-    Object(T value, typename std::enable_if<std::is_floating_point<T>::value>::type* = 0) :
-        type_(Type::Double), double_(value)
-    {}
-
-    template <typename T>
-    Object(T value, typename std::enable_if<std::is_convertible<T, std::string>::value>::type* = 0) :
-        type_(Type::String), string_(value)
-    {}
+inline void Object::Parser::enterSchemaMember(const Frame& frame, std::size_t offset)
+{
+    if (!schema_)
+    {
+        return;
+    }
+    schemaNode_ = frame.is_object ? schema_->member(frame.schema, key_) : schema_->element(frame.schema);
+    if (schemaNode_ == Schema::none)
+    {
+        throw Error("Schema violation: unexpected member '" + key_ + "'", offset);
+    }
+}
 
-    Object(std::nullptr_t) :
-        type_(Type::Null )
-    {}
+#if defined(__unix__) || defined(__APPLE__)
 
-    [[nodiscard]] bool isNull() const
+/**
+ * Sidecar index of the byte ranges of the elements of a top-level array, or of the members of
+ * a top-level object, of a JSON file. It is built in a single streaming pass and can be saved
+ * next to the file; afterwards single elements are read with pread() and parsed on their own,
+ * without scanning the rest of the file.
+ */
+class Index
+{
+public:
+    struct Entry
     {
-        return type_ == Type::Null;
-    }
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::string key;
+    }; /* End of struct Entry */
 
-    [[nodiscard]] bool isEmpty() const
+    /**
+     * Scans the file at path. Only the structure is checked here; each element is fully
+     * validated when it is read.
+     */
+    static Index build(const std::string& path, std::size_t chunkSize = 1024 * 1024)
     {
-        if (isNull()) { return true; }
-        if (type_ == Type::Object) { return map_.size() == 0; }
-        if (type_ == Type::Array) { return vector_.size() == 0; }
-        return false;
+        Descriptor file(path, O_RDONLY);
+        Builder builder;
+        std::vector<char> chunk(chunkSize);
+        for (;;)
+        {
+            ssize_t size = ::read(file.fd, chunk.data(), chunk.size());
+            if (size < 0 && errno == EINTR) { continue; }
+            if (size < 0) { throw Error("Cannot read file: " + path); }
+            if (size == 0) { break; }
+            builder.feed(chunk.data(), static_cast<std::size_t>(size));
+        }
+        builder.finish();
+
+        Index index;
+        index.type_ = builder.type;
+        index.entries_ = std::move(builder.entries);
+        index.sortKeys();
+        return index;
     }
 
-    [[nodiscard]] std::size_t size() const
+    static Index load(const std::string& path)
     {
-        if (type_ == Type::Object)
+        Descriptor file(path, O_RDONLY);
+        std::string data;
+        char chunk[64 * 1024];
+        for (;;)
         {
-            return map_.size();
+            ssize_t size = ::read(file.fd, chunk, sizeof(chunk));
+            if (size < 0 && errno == EINTR) { continue; }
+            if (size < 0) { throw Error("Cannot read file: " + path); }
+            if (size == 0) { break; }
+            data.append(chunk, static_cast<std::size_t>(size));
         }
-        if (type_ == Type::Array)
+
+        std::size_t position = 0;
+        auto take = [&data, &position](std::size_t size) {
+            if (data.size() - position < size) { throw Error("Invalid index file"); }
+            position += size;
+            return data.data() + position - size;
+        };
+        auto takeInteger = [&take](std::size_t size) {
+            auto bytes = reinterpret_cast<const unsigned char *>(take(size));
+            std::uint64_t value = 0;
+            for (std::size_t i = size; i > 0; --i) { value = (value << 8) | bytes[i - 1]; }
+            return value;
+        };
+
+        if (std::string_view(take(magic.size()), magic.size()) != magic || takeInteger(4) != version)
         {
-            return vector_.size();
+            throw Error("Invalid index file");
         }
-        throw Error("Invalid type");
+        Index index;
+        index.type_ = static_cast<Type>(takeInteger(1));
+        if (index.type_ != Type::Array && index.type_ != Type::Object)
+        {
+            throw Error("Invalid index file");
+        }
+        std::uint64_t count = takeInteger(8);
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            Entry entry;
+            entry.offset = takeInteger(8);
+            entry.length = takeInteger(8);
+            std::size_t length = takeInteger(4);
+            entry.key.assign(take(length), length);
+            index.entries_.push_back(std::move(entry));
+        }
+        index.sortKeys();
+        return index;
     }
 
-    [[nodiscard]] Type type() const
+    void save(const std::string& path) const
     {
-        return type_;
-    }
+        std::string data(magic);
+        auto putInteger = [&data](std::uint64_t value, std::size_t size) {
+            for (std::size_t i = 0; i < size; ++i, value >>= 8) { data += static_cast<char>(value & 0xFF); }
+        };
+        putInteger(version, 4);
+        putInteger(static_cast<std::uint64_t>(type_), 1);
+        putInteger(entries_.size(), 8);
+        for (auto& entry: entries_)
+        {
+            putInteger(entry.offset, 8);
+            putInteger(entry.length, 8);
+            putInteger(entry.key.size(), 4);
+            data += entry.key;
+        }
 
-    bool toBoolean() const
-    {
-        if (type_ != Type::Boolean) { throw Error("Invalid type"); }
-        return boolean_;
+        Descriptor file(path, O_WRONLY | O_CREAT | O_TRUNC);
+        std::size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t result = ::write(file.fd, data.data() + written, data.size() - written);
+            if (result < 0 && errno == EINTR) { continue; }
+            if (result < 0) { throw Error("Cannot write file: " + path); }
+            written += static_cast<std::size_t>(result);
+        }
     }
 
-    std::int64_t toInteger() const
+    /**
+     * Type of the indexed top-level value: Type::Array or Type::Object.
+     */
+    [[nodiscard]] Type type() const
     {
-        if (type_ != Type::Integer) { throw Error("Invalid type"); }
-        return integer_;
+        return type_;
     }
 
-    double toDouble() const
+    [[nodiscard]] std::size_t size() const
     {
-        if (type_ != Type::Double) { throw Error("Invalid type"); }
-        return double_;
+        return entries_.size();
     }
 
-    std::string toString() const
+    const Entry& at(std::size_t index) const
     {
-        if (type_ != Type::String) { throw Error("Invalid type"); }
-        return string_;
+        if (index >= entries_.size()) { throw Error("Index out of range"); }
+        return entries_[index];
     }
 
-    void clear()
+    /**
+     * Finds the entry of a top-level member; for duplicated keys the last one wins, as in parsing.
+     */
+    [[nodiscard]] const Entry *find(std::string_view key) const
     {
-        type_ = Type::Null;
-        string_.clear();
-        vector_.clear();
-        map_.clear();
+        auto it = std::upper_bound(sorted_.begin(), sorted_.end(), key, [this](std::string_view lhs, std::size_t rhs) {
+            return lhs < entries_[rhs].key;
+        });
+        if (it == sorted_.begin() || entries_[*(it - 1)].key != key) { return nullptr; }
+        return &entries_[*(it - 1)];
     }
 
-    void append(const Object& value)
+    Object read(int fd, const Entry& entry, const Object::Parser::Options& options = {}) const
     {
-        if (type_ != Type::Array)
+        std::string data(entry.length, '\0');
+        std::size_t done = 0;
+        while (done < data.size())
         {
-            setType(Type::Array);
+            ssize_t result = ::pread(fd, data.data() + done, data.size() - done, static_cast<off_t>(entry.offset + done));
+            if (result < 0 && errno == EINTR) { continue; }
+            if (result <= 0) { throw Error("Cannot read indexed element"); }
+            done += static_cast<std::size_t>(result);
         }
-        vector_.push_back(value);
+        return Object::Parser(options).fromString(data);
     }
 
-    bool contains(const std::string& key) const
+    Object get(const std::string& path, std::size_t index) const
     {
-        if (type_ != Type::Object) { throw Error("Invalid Type"); }
-        return map_.find(key) != map_.end();
+        return read(Descriptor(path, O_RDONLY).fd, at(index));
     }
 
-    void loads(const std::string& data)
+    Object get(const std::string& path, std::string_view key) const
     {
-        if (data.empty())
-        {
-            clear();
-            return;
-        }
-        *this = Object::Parser().fromString(data);
+        const Entry *entry = find(key);
+        if (!entry) { throw Error("Key not found"); }
+        return read(Descriptor(path, O_RDONLY).fd, *entry);
     }
 
-    std::string dumps(bool pretty = true, std::string ident = "") const
+private:
+    static constexpr std::string_view magic = "LJSONIDX";
+    static constexpr std::uint64_t version = 1;
+
+    struct Descriptor
     {
-        if (type_ == Type::Null)
+        int fd;
+
+        Descriptor(const std::string& path, int flags) :
+            fd(::open(path.c_str(), flags, 0644))
         {
-            return "null";
+            if (fd < 0) { throw Error("Cannot open file: " + path); }
         }
-        if (type_ == Type::Boolean) { return boolean_ ? "true" : "false"; }
-        if (type_ == Type::Integer) { return std::to_string(integer_); }
-        if (type_ == Type::Double)
+
+        Descriptor(const Descriptor&) = delete;
+        Descriptor& operator=(const Descriptor&) = delete;
+
+        ~Descriptor()
         {
-            std::ostringstream oss;
-            oss << std::setprecision(8) << std::noshowpoint << double_;
-            return oss.str();
+            ::close(fd);
         }
-        if (type_ == Type::String) { return std::string("\"") + string_ + std::string("\""); }
-        if (type_ == Type::Array)
+    }; /* End of struct Descriptor */
+
+    /**
+     * Incremental scanner fed with consecutive chunks of the file. It tracks strings and bracket
+     * nesting only, recording where each value directly inside the top-level container starts
+     * and ends.
+     */
+    class Builder
+    {
+    public:
+        void feed(const char *data, std::size_t size)
         {
-            std::ostringstream oss;
-            oss << "[";
-            bool first_element = true;
-            for (auto& object: vector_)
+            for (std::size_t i = 0; i < size; ++i, ++offset_)
             {
-                if (first_element) { first_element = false; }
-                else
+                char c = data[i];
+                if (in_string_)
                 {
-                    oss << ",";
-                    if (pretty) { oss << " "; }
+                    if (escape_)
+                    {
+                        escape_ = false;
+                        capture(c);
+                        continue;
+                    }
+                    if (c != '"' && c != '\\')
+                    {
+                        std::size_t run = std::max<std::size_t>(1, detail::scanPlainInput(data + i, size - i));
+                        for (std::size_t j = 0; j < run; ++j) { capture(data[i + j]); }
+                        i += run - 1;
+                        offset_ += run - 1;
+                        continue;
+                    }
+                    if (c == '\\')
+                    {
+                        escape_ = true;
+                        capture(c);
+                        continue;
+                    }
+                    in_string_ = false;
+                    if (phase_ == Phase::Key) { phase_ = Phase::Colon; }
+                    else if (phase_ == Phase::Value && brackets_.size() == 1) { end_ = offset_ + 1; }
+                    continue;
                 }
-                oss << object.dumps(pretty, ident);
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r') { continue; }
+                step(c);
             }
-            oss << "]";
-            return oss.str();
         }
-        if (type_ == Type::Object)
+
+        void finish() const
         {
-            std::ostringstream oss;
-            oss << "{";
-            if (pretty) { oss << "\n"; }
-            auto new_ident = ident + "  ";
-            bool first_element = true;
-            for (auto& [key, object]: map_)
-            {
-                if (first_element) { first_element = false; }
-                else
-                {
-                    oss << ",";
-                    if (pretty) { oss << "\n"; }
-                }
-                if (pretty) { oss << new_ident; }
-                oss << "\"" << key << "\":";
-                if (pretty) { oss << " "; }
-                oss << object.dumps(pretty, new_ident);
-            }
-            if (pretty) { oss << "\n" << ident; }
-            oss <<  "}";
-            return oss.str();
+            if (!closed_) { fail("unexpected end of input"); }
         }
-        throw Error("Invalid Type");
-    }
 
-    template <typename T>
-    typename std::enable_if<std::is_same<T, bool>::value, Object&>::type operator=(T value)
-    {
-        setType(Type::Boolean);
-        boolean_ = value;
-        return *this;
-    }
+        Type type{Type::Array};
+        std::vector<Entry> entries;
 
-    template <typename T>
-    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, Object&>::type operator=(T value)
-    {
-        setType(Type::Integer);
-        integer_ = value;
-        return *this;
-    }
+    private:
+        enum class Phase
+        {
+            Key,
+            Colon,
+            Start,
+            Value
+        }; /* End of enum Phase */
 
-    template <typename T>
-    typename std::enable_if<std::is_floating_point<T>::value, Object&>::type operator=(T value)
-    {
-        setType(Type::Double);
-        double_ = value;
-        return *this;
-    }
+        std::uint64_t offset_{};
+        std::uint64_t start_{};
+        std::uint64_t end_{};
+        std::string brackets_;
+        std::string key_;
+        Phase phase_{Phase::Start};
+        bool in_string_{};
+        bool escape_{};
+        bool after_comma_{};
+        bool closed_{};
 
-    template <typename T>
-    typename std::enable_if<std::is_convertible<T, std::string>::value, Object&>::type operator=(T value)
-    {
-        setType(Type::String);
-        string_ = std::string(value);
-        return *this;
-    }
+        [[noreturn]] void fail(const std::string& reason) const
+        {
+            throw Error("Invalid JSON: " + reason, offset_);
+        }
 
-    Object& operator[](const std::string& key)
-    {
-        if (type_ != Type::Object)
+        void capture(char c)
         {
-            setType(Type::Object);
+            if (phase_ == Phase::Key) { key_ += c; }
         }
-        return map_[key];
-    }
 
-    Object& operator[](std::uint32_t index)
-    {
-        if (type_ != Type::Array)
+        void open(char c)
         {
-            setType(Type::Array);
+            brackets_ += (c == '{') ? '}' : ']';
         }
-        if (index >= vector_.size())
+
+        void step(char c)
         {
-            vector_.resize(index + 1);
+            if (closed_) { fail("unexpected trailing characters"); }
+            if (brackets_.empty())
+            {
+                if (c != '{' && c != '[') { fail("top-level value is not an array or object"); }
+                type = (c == '{') ? Type::Object : Type::Array;
+                phase_ = (c == '{') ? Phase::Key : Phase::Start;
+                open(c);
+                return;
+            }
+            if (brackets_.size() > 1)
+            {
+                if (c == '"') { in_string_ = true; }
+                else if (c == '{' || c == '[') { open(c); }
+                else if (c == '}' || c == ']')
+                {
+                    if (c != brackets_.back()) { fail("mismatched bracket"); }
+                    brackets_.pop_back();
+                    if (brackets_.size() == 1) { end_ = offset_ + 1; }
+                }
+                return;
+            }
+
+            bool is_object = (type == Type::Object);
+            switch (phase_) {
+                case Phase::Key:
+                    if (c == '}' && !after_comma_) { close(); return; }
+                    if (c != '"') { fail("expected '\"'"); }
+                    key_.clear();
+                    in_string_ = true;
+                    return;
+                case Phase::Colon:
+                    if (c != ':') { fail("expected ':'"); }
+                    phase_ = Phase::Start;
+                    return;
+                case Phase::Start:
+                    if (c == ']' && !is_object && !after_comma_) { close(); return; }
+                    if (c == ',' || c == ':' || c == ']' || c == '}') { fail("unexpected character"); }
+                    start_ = offset_;
+                    end_ = offset_ + 1;
+                    phase_ = Phase::Value;
+                    break;
+                case Phase::Value:
+                    if (c == ',' || c == brackets_.back())
+                    {
+                        addEntry();
+                        if (c == ',')
+                        {
+                            phase_ = is_object ? Phase::Key : Phase::Start;
+                            after_comma_ = true;
+                        }
+                        else { close(); }
+                        return;
+                    }
+                    if (c == ']' || c == '}') { fail("mismatched bracket"); }
+                    end_ = offset_ + 1;
+                    break;
+            }
+            if (c == '"') { in_string_ = true; }
+            else if (c == '{' || c == '[') { open(c); }
         }
-        return vector_[index];
-    }
 
-    bool operator==(const Object& rhs) const
-    {
-        if (type_ != rhs.type_)
+        void addEntry()
         {
-            return false;
+            Entry entry{start_, end_ - start_, std::string()};
+            if (type == Type::Object)
+            {
+                entry.key = Object::Parser().fromString("\"" + key_ + "\"").toString();
+            }
+            entries.push_back(std::move(entry));
         }
 
-        switch (type_) {
-            case Type::Boolean: return boolean_ == rhs.boolean_;
-            case Type::Integer: return integer_ == rhs.integer_;
-            case Type::Double: return double_ == rhs.double_;
-            case Type::String: return string_ == rhs.string_;
-            case Type::Array: return vector_ == rhs.vector_;
-            case Type::Object: return map_ == rhs.map_;
-            case Type::Null: return true;
-            default: return false;
+        void close()
+        {
+            brackets_.pop_back();
+            closed_ = true;
         }
-    }
+    }; /* End of subclass Builder */
 
-    bool operator!=(const Object& rhs) const
-    {
-        return !(*this == rhs);
-    }
+    Type type_{Type::Array};
+    std::vector<Entry> entries_;
+    std::vector<std::size_t> sorted_;
 
-    friend std::ostream& operator<<(std::ostream& os, const Object& object)
+    void sortKeys()
     {
-        os << object.dumps();
-        return os;
+        sorted_.clear();
+        if (type_ != Type::Object) { return; }
+        sorted_.resize(entries_.size());
+        for (std::size_t i = 0; i < sorted_.size(); ++i) { sorted_[i] = i; }
+        std::stable_sort(sorted_.begin(), sorted_.end(), [this](std::size_t lhs, std::size_t rhs) {
+            return entries_[lhs].key < entries_[rhs].key;
+        });
     }
+}; /* End of class Index */
 
-private:
-    Type type_;
-    std::int64_t integer_{};
-    double double_{};
-    bool boolean_{};
-    std::string string_;
-    std::vector<Object> vector_;
-    std::map<std::string, Object> map_;
+#endif
 
-    void setType(Type type)
+inline static Object parse(const std::string& data)
+{
+    if (data.empty())
     {
-        clear();
-        type_ = type;
+        return Object();
     }
-}; /* End of class Object */
+    return Object::Parser().fromString(data);
+}
 
-inline static Object parse(const std::string& data)
+inline static Object parse(const std::string& data, const Object::Parser::Options& options)
 {
     if (data.empty())
     {
         return Object();
     }
-    return Object::Parser().fromString(data);
+    return Object::Parser(options).fromString(data);
 }
 
 } /* End of namespace json */
 
+namespace std {
+
+template <>
+struct hash<json::Object>
+{
+    std::size_t operator()(const json::Object& object) const
+    {
+        return object.hash();
+    }
+}; /* End of struct hash<json::Object> */
+
+} /* End of namespace std */
+
 using json::operator "" _;
 
 #endif /* !_JSON_H_ */
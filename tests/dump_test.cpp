@@ -68,3 +68,13 @@ TEST(DumpTest, checkAdvancedObjectPrettyDumpsWorksFine)
 
     EXPECT_EQ(obj.dumps(true), expected);
 }
+
+TEST(DumpTest, checkStringsAreEscapedCorrectly)
+{
+    EXPECT_EQ(json::Object("a\"b\\c").dumps(), "\"a\\\"b\\\\c\"");
+    EXPECT_EQ(json::Object("\b\f\n\r\t").dumps(), "\"\\b\\f\\n\\r\\t\"");
+    EXPECT_EQ(json::Object(std::string("\x01\x1f", 2)).dumps(), "\"\\u0001\\u001f\"");
+    EXPECT_EQ(json::Object("za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87").dumps(), "\"za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87\"");
+    EXPECT_EQ((json::Object{{"say \"hi\""_, "line1\nline2 with a much longer tail"}}.dumps(false)),
+              "{\"say \\\"hi\\\"\":\"line1\\nline2 with a much longer tail\"}");
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include "json.h"
+
+using namespace testing;
+
+class IndexTest : public Test
+{
+protected:
+    std::string data_path_ = "index_test_data.json";
+    std::string index_path_ = "index_test_data.idx";
+
+    void write(const std::string& content)
+    {
+        std::ofstream(data_path_, std::ios::binary) << content;
+    }
+
+    void TearDown() override
+    {
+        std::remove(data_path_.c_str());
+        std::remove(index_path_.c_str());
+    }
+};
+
+TEST_F(IndexTest, checkArrayElementsAreIndexedAndReadBack)
+{
+    const std::string content = " [\n  {\"key1\": \"a, b ] }\", \"key2\": [1, [2, {}]]},\n  -12.5e3 , \"x\\\"]\",\n"
+                                "  null, [], {\"key3\": \"\\u0041\xC4\x85\"}  \n] \n";
+    write(content);
+    json::Object expected = json::parse(content);
+
+    for (std::size_t chunk_size: {1, 3, 7, 4096})
+    {
+        json::Index index = json::Index::build(data_path_, chunk_size);
+        EXPECT_EQ(index.type(), json::Type::Array);
+        ASSERT_EQ(index.size(), expected.size());
+        for (std::size_t i = 0; i < index.size(); ++i)
+        {
+            EXPECT_EQ(index.get(data_path_, i), expected.at(i)) << i;
+        }
+    }
+
+    json::Index::build(data_path_).save(index_path_);
+    json::Index loaded = json::Index::load(index_path_);
+    ASSERT_EQ(loaded.size(), 6);
+    EXPECT_EQ(loaded.at(1).offset, content.find("-12.5e3"));
+    EXPECT_EQ(loaded.at(1).length, 7);
+    EXPECT_EQ(loaded.get(data_path_, 5), expected.at(5));
+    EXPECT_THROW(loaded.at(6), json::Error);
+}
+
+TEST_F(IndexTest, checkObjectMembersAreFoundByKey)
+{
+    write("{\"key1\": {\"a\": [1, 2]}, \"k\\u0065y2\": \"text\", \"key3\": 7, \"key1\": true}");
+
+    json::Index::build(data_path_).save(index_path_);
+    json::Index index = json::Index::load(index_path_);
+    EXPECT_EQ(index.type(), json::Type::Object);
+    EXPECT_EQ(index.size(), 4);
+    EXPECT_EQ(index.at(0).key, "key1");
+    EXPECT_EQ(index.get(data_path_, "key2"), json::Object("text"));
+    EXPECT_EQ(index.get(data_path_, "key3"), json::Object(7));
+    EXPECT_EQ(index.get(data_path_, "key1"), json::Object(true));
+    EXPECT_EQ(index.find("missing"), nullptr);
+    EXPECT_THROW(index.get(data_path_, "missing"), json::Error);
+}
+
+TEST_F(IndexTest, checkEmptyAndMalformedDocuments)
+{
+    write(" [ ] ");
+    EXPECT_EQ(json::Index::build(data_path_).size(), 0);
+    write("{}");
+    EXPECT_EQ(json::Index::build(data_path_).size(), 0);
+
+    for (const char *sample: {"[1, 2", "[1, 2,]", "{\"a\" 1}", "[1}", "[[1]]]", "12", "[\"abc]", "{\"a\": 1,}"})
+    {
+        write(sample);
+        EXPECT_THROW(json::Index::build(data_path_), json::Error) << sample;
+    }
+
+    write("not an index");
+    EXPECT_THROW(json::Index::load(data_path_), json::Error);
+    EXPECT_THROW(json::Index::load("missing.idx"), json::Error);
+}
@@ -3,6 +3,8 @@
  */
 
 #include <iostream>
+#include <thread>
+#include <unordered_set>
 #include <gtest/gtest.h>
 #include "json.h"
 
@@ -109,3 +111,197 @@ TEST(ObjectTest, checkComplexObjectAssignmentWorksCorrectly)
     EXPECT_EQ(obj["key10"].type(), json::Type::Boolean);
     EXPECT_EQ(obj["key10"].toBoolean(), false);
 }
+
+TEST(ObjectTest, checkStructuralHashFollowsEquality)
+{
+    json::Object obj1{{"key1"_, {1, 2, 3}}, {"key2"_, {{"key3"_, "abc"}}}};
+    json::Object obj2 = json::parse("{\"key2\": {\"key3\": \"abc\"}, \"key1\": [1, 2, 3]}");
+
+    EXPECT_EQ(obj1.hash(), obj2.hash());
+    EXPECT_EQ(obj1, obj2);
+    EXPECT_EQ(json::Object(0.0).hash(), json::Object(-0.0).hash());
+    EXPECT_NE(json::Object(1).hash(), json::Object(1.0).hash());
+
+    obj2["key2"]["key3"] = "abd";
+    EXPECT_NE(obj1.hash(), obj2.hash());
+    EXPECT_NE(obj1, obj2);
+
+    obj2["key2"]["key3"] = "abc";
+    EXPECT_EQ(obj1.hash(), obj2.hash());
+    EXPECT_EQ(obj1, obj2);
+}
+
+TEST(ObjectTest, checkHashFollowsChildMutatedThroughKeptReference)
+{
+    json::Object a, b;
+    auto& child = a["k"];
+    child = 1;
+    b["k"] = 2;
+
+    EXPECT_NE(a.hash(), b.hash());
+    child = 2;
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(a, b);
+
+    a.makeShareable();
+    b.makeShareable();
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(a, b);
+}
+
+TEST(ObjectTest, checkObjectsCanBeUsedAsUnorderedKeys)
+{
+    std::unordered_set<json::Object> objects;
+    objects.insert(json::parse("{\"id\": 1, \"tags\": [\"a\", \"b\"]}"));
+    objects.insert(json::parse("{\"tags\": [\"a\", \"b\"], \"id\": 1}"));
+    objects.insert(json::parse("{\"id\": 2, \"tags\": [\"a\", \"b\"]}"));
+    objects.insert(json::Object());
+
+    EXPECT_EQ(objects.size(), 3);
+    EXPECT_EQ(objects.count(json::Object{{"id"_, 1}, {"tags"_, {"a", "b"}}}), 1);
+}
+
+TEST(ObjectTest, checkCopyOnWriteKeepsCopiesIndependent)
+{
+    json::Object original = json::parse("{\"key1\": {\"key2\": [1, 2, 3]}, \"key3\": \"abc\"}");
+    json::Object copy = original;
+
+    EXPECT_EQ(copy, original);
+    copy["key1"]["key2"][1] = 20;
+    copy["key4"] = true;
+
+    EXPECT_EQ(original, json::parse("{\"key1\": {\"key2\": [1, 2, 3]}, \"key3\": \"abc\"}"));
+    EXPECT_EQ(copy, json::parse("{\"key1\": {\"key2\": [1, 20, 3]}, \"key3\": \"abc\", \"key4\": true}"));
+}
+
+TEST(ObjectTest, checkRetainedReferenceDoesNotLeakIntoCopies)
+{
+    json::Object original;
+    json::Object& nested = original["key1"]["key2"];
+    nested = 1;
+
+    json::Object copy = original;
+    nested = 2;
+    EXPECT_EQ(copy["key1"]["key2"].toInteger(), 1);
+    EXPECT_EQ(original["key1"]["key2"].toInteger(), 2);
+
+    original.makeShareable();
+    json::Object shared = original;
+    shared["key1"]["key2"] = 3;
+    EXPECT_EQ(original["key1"]["key2"].toInteger(), 2);
+}
+
+TEST(ObjectTest, checkSharedTreeCanBeCopiedAndReadFromManyThreads)
+{
+    const json::Object config = json::parse("{\"key1\": {\"key2\": [1, 2, 3]}, \"key3\": \"abc\"}");
+    const std::string expected = config.dumps(false);
+
+    std::vector<std::thread> workers;
+    std::vector<char> results(8, false);
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        workers.emplace_back([&config, &expected, &results, i] {
+            bool ok = true;
+            for (int j = 0; j < 100; ++j)
+            {
+                json::Object request = config;
+                ok = ok && request.hash() == config.hash() && request.dumps(false) == expected;
+                request["key1"]["key2"].append(j);
+                ok = ok && request["key1"]["key2"].size() == 4;
+            }
+            results[i] = ok;
+        });
+    }
+    for (auto& worker: workers) { worker.join(); }
+
+    for (char result: results) { EXPECT_TRUE(result); }
+    EXPECT_EQ(config.dumps(false), expected);
+}
+
+TEST(ObjectTest, checkIterationOverMembersAndElements)
+{
+    const json::Object obj = json::parse("{\"key1\": 1, \"key2\": [true, \"abc\"], \"key3\": null}");
+
+    std::vector<std::string_view> keys;
+    for (auto it = obj.begin(); it != obj.end(); ++it)
+    {
+        keys.push_back(it.key());
+    }
+    EXPECT_EQ(keys, (std::vector<std::string_view>{"key1", "key2", "key3"}));
+
+    std::size_t count = 0;
+    for (auto [key, value]: obj.items())
+    {
+        EXPECT_EQ(&value, &obj.at(key));
+        ++count;
+    }
+    EXPECT_EQ(count, 3);
+
+    std::vector<json::Type> types;
+    for (const auto& element: obj.at("key2"))
+    {
+        types.push_back(element.type());
+    }
+    EXPECT_EQ(types, (std::vector<json::Type>{json::Type::Boolean, json::Type::String}));
+    EXPECT_EQ(std::distance(obj.at("key2").begin(), obj.at("key2").end()), 2);
+    EXPECT_EQ(json::Object().begin(), json::Object().end());
+    EXPECT_THROW(json::Object(1).begin(), json::Error);
+}
+
+TEST(ObjectTest, checkConstAccessorsNeverMutate)
+{
+    const json::Object obj = json::parse("{\"key1\": \"abc\", \"key2\": [1, 2]}");
+
+    EXPECT_EQ(obj.at("key1").asStringView(), "abc");
+    EXPECT_EQ(obj.at("key2").at(1).toInteger(), 2);
+    EXPECT_EQ(obj.find("key1").key(), "key1");
+    EXPECT_EQ(obj.find("missing"), obj.end());
+    EXPECT_TRUE(obj.contains(std::string_view("key2")));
+    EXPECT_THROW(obj.at("missing"), json::Error);
+    EXPECT_THROW(obj.at("key2").at(2), json::Error);
+    EXPECT_THROW(obj.at(0), json::Error);
+    EXPECT_THROW(obj.at("key2").asStringView(), json::Error);
+    EXPECT_EQ(obj.size(), 2);
+}
+
+TEST(ObjectTest, checkMutableFindOnSharedObject)
+{
+    json::Object obj = json::parse("{\"key1\": 1, \"key2\": 2}");
+    json::Object copy = obj;
+
+    EXPECT_TRUE(copy.find("missing") == copy.end());
+    auto it = copy.find("key2");
+    ASSERT_TRUE(it != copy.end());
+    *it = 20;
+    EXPECT_EQ(copy["key2"].toInteger(), 20);
+    EXPECT_EQ(obj["key2"].toInteger(), 2);
+
+    json::Object::const_iterator found = copy.find("key1");
+    EXPECT_EQ(found.key(), "key1");
+    EXPECT_TRUE(copy.find("missing") == copy.cend());
+    EXPECT_TRUE(copy.cend() == copy.find("missing"));
+    EXPECT_FALSE(copy.find("key1") != found);
+    EXPECT_FALSE(found != copy.find("key1"));
+    EXPECT_THROW(static_cast<void>(json::Object(1).find("key1")), json::Error);
+}
+
+TEST(ObjectTest, checkMutableIterationAndReserve)
+{
+    json::Object obj = json::parse("[1, 2, 3]");
+    json::Object copy = obj;
+    for (auto& element: obj)
+    {
+        element = element.toInteger() * 10;
+    }
+    EXPECT_EQ(obj, json::parse("[10, 20, 30]"));
+    EXPECT_EQ(copy, json::parse("[1, 2, 3]"));
+
+    json::Object array;
+    array.reserve(100);
+    EXPECT_EQ(array.type(), json::Type::Array);
+    for (int i = 0; i < 100; ++i)
+    {
+        array.append(i);
+    }
+    EXPECT_EQ(array.size(), 100);
+}
@@ -2,6 +2,7 @@
  * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
  */
 
+#include <unordered_set>
 #include <gtest/gtest.h>
 #include "json.h"
 
@@ -104,11 +105,11 @@ TEST(ParserTest, checkParserHandlesIntegersCorrectly)
 
 TEST(ParserTest, checkParserHandlesDoublesCorrectly)
 {
-    EXPECT_EQ(json::parse("1000.").type(), json::Type::Double);
-    EXPECT_EQ(json::parse(" 1023.").toDouble(), 1023.);
+    EXPECT_EQ(json::parse("1000.0").type(), json::Type::Double);
+    EXPECT_EQ(json::parse(" 1023.0").toDouble(), 1023.0);
     EXPECT_EQ(json::parse(" 123.123\n").toDouble(), 123.123);
     EXPECT_EQ(json::parse(" \r10e3\n").toDouble(), 10e3);
-    EXPECT_EQ(json::parse(" \t0.").toDouble(), 0.);
+    EXPECT_EQ(json::parse(" \t0.0").toDouble(), 0.0);
     EXPECT_EQ(json::parse("      -10.12\r").toDouble(), -10.12);
     EXPECT_EQ(json::parse(" \r-1000000.00001\n").toDouble(), -1000000.00001);
     EXPECT_EQ(json::parse(" \r-10.12e3\n").toDouble(), -10.12e3);
@@ -119,7 +120,310 @@ TEST(ParserTest, checkParserHandlesDoublesCorrectly)
 TEST(ParserTest, checkParserHandlesStringsCorrectly)
 {
     EXPECT_EQ(json::parse("\"text\"").type(), json::Type::String);
-    EXPECT_EQ(json::parse(" \"abc abc abc\n\r\t\" \r\r\r\n\t     ").toString(), "abc abc abc\n\r\t");
+    EXPECT_EQ(json::parse(" \"abc abc abc\\n\\r\\t\" \r\r\r\n\t     ").toString(), "abc abc abc\n\r\t");
     EXPECT_THROW(json::parse(" 12     ").toString(), json::Error);
     EXPECT_THROW(json::parse("\"abc\"").toInteger(), json::Error);
-}
\ No newline at end of file
+}
+
+TEST(ParserTest, checkParserDecodesEscapeSequences)
+{
+    EXPECT_EQ(json::parse(R"("a\"b\\c\/d")").toString(), "a\"b\\c/d");
+    EXPECT_EQ(json::parse(R"("\b\f\n\r\t")").toString(), "\b\f\n\r\t");
+    EXPECT_EQ(json::parse(R"("\u0041\u00e9\u20AC")").toString(), "A\xC3\xA9\xE2\x82\xAC");
+    EXPECT_EQ(json::parse(R"("\ud83d\ude00")").toString(), "\xF0\x9F\x98\x80");
+    EXPECT_EQ(json::parse(R"({"k\u0065y": 1})")["key"].toInteger(), 1);
+    EXPECT_THROW(json::parse(R"("\x")"), json::Error);
+    EXPECT_THROW(json::parse(R"("\u12G4")"), json::Error);
+    EXPECT_THROW(json::parse(R"("\ud83d")"), json::Error);
+    EXPECT_THROW(json::parse(R"("\ud83d\u0041")"), json::Error);
+    EXPECT_THROW(json::parse(R"("\ude00")"), json::Error);
+    EXPECT_THROW(json::parse("\"abc"), json::Error);
+    EXPECT_THROW(json::parse("\"abc\\"), json::Error);
+}
+
+TEST(ParserTest, checkParserRejectsUnescapedControlCharacters)
+{
+    std::string padding(20, 'x');
+    EXPECT_THROW(json::parse("\"a\nb\""), json::Error);
+    EXPECT_THROW(json::parse("\"a\tb\""), json::Error);
+    EXPECT_THROW(json::parse(std::string("\"a\0b\"", 5)), json::Error);
+    EXPECT_THROW(json::parse("{\"" + padding + "\x1F\": 1}"), json::Error);
+    EXPECT_THROW(json::parse("[\"" + padding + "\x01" + padding + "\"]"), json::Error);
+    EXPECT_EQ(json::parse("\"" + padding + "\x7F\"").toString(), padding + "\x7F");
+}
+
+TEST(ParserTest, checkParserValidatesUtf8)
+{
+    EXPECT_EQ(json::parse("\"za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87 g\xC4\x99\xC5\x9Bl\xC4\x85 ja\xC5\xBA\xC5\x84\"").toString(),
+              "za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87 g\xC4\x99\xC5\x9Bl\xC4\x85 ja\xC5\xBA\xC5\x84");
+    EXPECT_EQ(json::parse("\"\xF0\x9F\x98\x80\"").toString(), "\xF0\x9F\x98\x80");
+    EXPECT_THROW(json::parse("\"\xC0\xAF\""), json::Error);
+    EXPECT_THROW(json::parse("\"\xED\xA0\x80\""), json::Error);
+    EXPECT_THROW(json::parse("\"\xF4\x90\x80\x80\""), json::Error);
+    EXPECT_THROW(json::parse("\"\xE2\x82\""), json::Error);
+    EXPECT_THROW(json::parse("\"0123456789abcdef0123456789\xFF\""), json::Error);
+}
+
+TEST(ParserTest, checkParserHandlesLongStringsWithEscapesAtAnyPosition)
+{
+    std::string plain(100, 'x');
+    for (std::size_t pos = 0; pos < plain.size(); pos += 7)
+    {
+        std::string expected = plain;
+        expected.insert(pos, "\"\n\xC4\x85");
+        std::string input = "\"" + plain + "\"";
+        input.insert(pos + 1, "\\\"\\n\xC4\x85");
+        EXPECT_EQ(json::parse(input).toString(), expected);
+        EXPECT_EQ(json::parse(json::Object(expected).dumps()).toString(), expected);
+    }
+}
+
+TEST(ParserTest, checkParserReportsOffsetOfInvalidInput)
+{
+    try
+    {
+        json::parse("{\"key1\": [1, 2,, 3]}");
+        FAIL() << "json::Error expected";
+    }
+    catch (const json::Error& error)
+    {
+        EXPECT_EQ(error.offset(), 15);
+    }
+    EXPECT_EQ(json::Error("Invalid type").offset(), json::Error::npos);
+    EXPECT_THROW(json::parse("[1, 2,]"), json::Error);
+    EXPECT_THROW(json::parse("{\"key\": 1,}"), json::Error);
+    EXPECT_THROW(json::parse("{\"key\" 1}"), json::Error);
+    EXPECT_THROW(json::parse("[1, 2"), json::Error);
+    EXPECT_THROW(json::parse("12 13"), json::Error);
+    EXPECT_THROW(json::parse("   "), json::Error);
+    EXPECT_THROW(json::parse("-"), json::Error);
+    EXPECT_THROW(json::parse("012"), json::Error);
+    EXPECT_THROW(json::parse("1e"), json::Error);
+    EXPECT_THROW(json::parse("1."), json::Error);
+    EXPECT_THROW(json::parse("[1.]"), json::Error);
+    EXPECT_THROW(json::parse("1.e5"), json::Error);
+}
+
+TEST(ParserTest, checkParserFlushesUnderflowToZeroAndRejectsOverflow)
+{
+    EXPECT_EQ(json::parse("1e-400").toDouble(), 0.0);
+    EXPECT_TRUE(std::signbit(json::parse("-1e-400").toDouble()));
+    EXPECT_EQ(json::parse("0.00012e-400").toDouble(), 0.0);
+    EXPECT_EQ(json::parse("123e-2").toDouble(), 1.23);
+    EXPECT_THROW(json::parse("1e400"), json::Error);
+    EXPECT_THROW(json::parse("-0.001e312"), json::Error);
+
+    json::Object::Parser::Options options;
+    options.lazyNumbers = true;
+    EXPECT_EQ(json::parse("1e-400", options).toDouble(), 0.0);
+    EXPECT_THROW(json::parse("1e400", options), json::Error);
+    EXPECT_THROW(json::parse("[-1.8e308]", options), json::Error);
+    EXPECT_THROW(json::parse("1" + std::string(400, '0'), options), json::Error);
+    EXPECT_EQ(json::parse("1.7e308", options).toDouble(), 1.7e308);
+    EXPECT_EQ(json::parse("0e999", options).toDouble(), 0.0);
+
+    std::unordered_set<json::Object> objects;
+    objects.insert(json::parse("[1.5e300, 1e-400]", options));
+    EXPECT_EQ(objects.count(json::parse("[1.5e300, 0.0]")), 1);
+}
+
+TEST(ParserTest, checkParserHandlesDeepNestingWithoutRecursion)
+{
+    std::string input = std::string(1000, '[') + std::string(1000, ']');
+    json::Object obj = json::parse(input);
+    EXPECT_EQ(obj.type(), json::Type::Array);
+
+    std::string hostile(1000000, '[');
+    try
+    {
+        json::parse(hostile);
+        FAIL() << "json::Error expected";
+    }
+    catch (const json::Error& error)
+    {
+        EXPECT_EQ(error.offset(), 1024);
+    }
+}
+
+TEST(ParserTest, checkParserEnforcesConfiguredLimits)
+{
+    json::Object::Parser::Options options;
+    options.maxDepth = 2;
+    EXPECT_NO_THROW(json::parse("{\"key\": [1]}", options));
+    EXPECT_THROW(json::parse("{\"key\": [[1]]}", options), json::Error);
+
+    options = json::Object::Parser::Options();
+    options.maxBytes = 8;
+    EXPECT_NO_THROW(json::parse("[1, 2]", options));
+    EXPECT_THROW(json::parse("[1, 2, 3, 4]", options), json::Error);
+
+    options = json::Object::Parser::Options();
+    options.maxStringLength = 3;
+    EXPECT_NO_THROW(json::parse("{\"abc\": \"\\u0041bc\"}", options));
+    EXPECT_THROW(json::parse("\"abcd\"", options), json::Error);
+    EXPECT_THROW(json::parse("{\"abcd\": 1}", options), json::Error);
+    EXPECT_THROW(json::parse("\"\\u0041bcd\"", options), json::Error);
+    try
+    {
+        json::parse("\"" + std::string(1000, 'x') + "\"", options);
+        FAIL() << "json::Error expected";
+    }
+    catch (const json::Error& error)
+    {
+        EXPECT_EQ(error.offset(), 5);
+    }
+
+    options = json::Object::Parser::Options();
+    options.maxMembers = 2;
+    EXPECT_NO_THROW(json::parse("[[1, 2], {\"a\": 1, \"b\": 2}]", options));
+    EXPECT_THROW(json::parse("[1, 2, 3]", options), json::Error);
+    EXPECT_THROW(json::parse("{\"a\": 1, \"b\": 2, \"c\": 3}", options), json::Error);
+}
+
+TEST(ParserTest, checkParserHandlesNestedDocumentsCorrectly)
+{
+    json::Object obj = json::parse("{\"key1\": [1, {\"key2\": null, \"key3\": [true, \"x\"]}, []], \"key4\": {}, \"key1\": 5}");
+    EXPECT_EQ(obj, json::Object({{"key1"_, 5}, {"key4"_, json::Object(json::Type::Object)}}));
+
+    obj = json::parse("[1, {\"key2\": null, \"key3\": [true, -2.5e1]}, []]");
+    EXPECT_EQ(obj, json::Object({1, {{"key2"_, nullptr}, {"key3"_, {true, -25.0}}}, json::Object(json::Type::Array)}));
+    EXPECT_EQ(json::parse("9223372036854775807").toInteger(), INT64_MAX);
+    EXPECT_EQ(json::parse("18446744073709551616").toDouble(), 18446744073709551616.0);
+}
+
+TEST(ParserTest, checkParsingIntoExistingObjectGivesSameResultAsFreshParse)
+{
+    std::list<std::string> samples{
+        "{\"key1\": [1, 2, 3], \"key2\": {\"key3\": \"abc\", \"key4\": null}}",
+        "{\"key1\": [1, {\"key5\": true}], \"key2\": {\"key4\": 1.5}}",
+        "{\"key2\": [\"abc\"], \"key6\": {}}",
+        "{\"key2\": {\"key3\": 1, \"key3\": 2}, \"key6\": []}",
+        "[1, [2, 3], {\"key1\": 4}]",
+        "[{\"key1\": 4}]",
+        "\"text\"",
+        "{\"key1\": [1, 2, 3], \"key2\": {\"key3\": \"abc\", \"key4\": null}}"
+    };
+
+    json::Object::Parser parser;
+    json::Object obj;
+    for (auto& sample: samples)
+    {
+        parser.fromString(sample, obj);
+        EXPECT_EQ(obj, json::parse(sample)) << sample;
+        EXPECT_EQ(obj.dumps(false), json::parse(sample).dumps(false)) << sample;
+    }
+}
+
+TEST(ParserTest, checkParsingIntoExistingObjectReusesNodesAndBuffers)
+{
+    json::Object::Parser parser;
+    json::Object obj;
+    parser.fromString("{\"key1\": \"a fairly long string value\", \"key2\": [1, 2, 3]}", obj);
+    const json::Object *key1 = &obj["key1"];
+    const json::Object *element = &obj["key2"][2];
+    const char *buffer = obj.at("key1").asStringView().data();
+
+    parser.fromString("{\"key1\": \"another long string value\", \"key2\": [4, 5, 6]}", obj);
+    EXPECT_EQ(&obj["key1"], key1);
+    EXPECT_EQ(&obj["key2"][2], element);
+    EXPECT_EQ(obj.at("key1").asStringView().data(), buffer);
+    EXPECT_EQ(obj["key2"][2].toInteger(), 6);
+}
+
+TEST(ParserTest, checkFailedLoadsLeavesObjectUnchanged)
+{
+    json::Object obj = json::parse("{\"a\": [1, 2, 3], \"b\": 2}");
+    json::Object expected = obj;
+
+    EXPECT_THROW(obj.loads("{\"a\": [9,"), json::Error);
+    EXPECT_EQ(obj, expected);
+    obj.loads("{\"a\": [9]}");
+    EXPECT_EQ(obj, json::parse("{\"a\": [9]}"));
+}
+
+TEST(ParserTest, checkParsingIntoSharedObjectDoesNotAffectCopies)
+{
+    json::Object::Parser parser;
+    json::Object obj = json::parse("{\"key1\": [1, 2, 3]}");
+    json::Object copy = obj;
+
+    parser.fromString("{\"key1\": [4]}", obj);
+    EXPECT_EQ(copy, json::parse("{\"key1\": [1, 2, 3]}"));
+    EXPECT_EQ(obj, json::parse("{\"key1\": [4]}"));
+}
+
+TEST(ParserTest, checkProjectionMaterializesOnlySelectedMembers)
+{
+    const std::string input = "{\"id\": 7, \"user\": {\"name\": \"abc\", \"email\": \"a\\u0040b\", \"age\": 30},"
+                              " \"events\": [{\"type\": \"click\"}, 1.5e3, null], \"items\": [1, 2, 3],"
+                              " \"meta\": {\"tags\": [\"x\", {\"y\": [true, false]}]}}";
+    json::Projection projection{"id", "user.name", "items", "meta.missing", "events.type"};
+    json::Object::Parser parser;
+
+    json::Object obj = parser.fromString(input, projection);
+    EXPECT_EQ(obj, json::parse("{\"id\": 7, \"user\": {\"name\": \"abc\"}, \"items\": [1, 2, 3], \"meta\": {}}"));
+
+    EXPECT_EQ(parser.fromString(input, json::Projection{"user"}), json::parse("{\"user\": {\"name\": \"abc\", \"email\": \"a@b\", \"age\": 30}}"));
+    EXPECT_EQ(parser.fromString(input, json::Projection{"user", "user.name"}).size(), 1);
+    EXPECT_EQ(parser.fromString(input, json::Projection{}), json::Object(json::Type::Object));
+    EXPECT_EQ(parser.fromString("[1, 2]", json::Projection{"id"}).type(), json::Type::Null);
+
+    json::Projection dotted;
+    dotted.add(std::vector<std::string>{"a.b"});
+    EXPECT_EQ(parser.fromString("{\"a.b\": 1, \"a\": {\"b\": 2}}", dotted), json::parse("{\"a.b\": 1}"));
+
+    json::Projection nested{"k1.k2"};
+    EXPECT_EQ(parser.fromString("{\"k1\": {\"k2\": 1}, \"k1\": 5}", nested), json::Object(json::Type::Object));
+    EXPECT_EQ(parser.fromString("{\"k1\": {\"k2\": 1}, \"k1\": {\"k3\": 2}}", nested), json::parse("{\"k1\": {}}"));
+
+    json::Object reused = json::parse("{\"k1\": {\"k2\": 0}, \"x\": 1}");
+    parser.fromString("{\"k1\": {\"k2\": 1}, \"k1\": 5}", nested, reused);
+    EXPECT_EQ(reused, json::Object(json::Type::Object));
+}
+
+TEST(ParserTest, checkProjectionStillValidatesSkippedMembers)
+{
+    json::Object::Parser parser;
+    json::Projection projection{"id"};
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": [1, 2,]}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": {\"a\" 1}}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": \"\\x\"}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": 01}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": [1}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": [1", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1, \"skip\": nul}", projection), json::Error);
+    EXPECT_THROW(parser.fromString("{\"id\": 1} x", projection), json::Error);
+
+    json::Object::Parser::Options options;
+    options.maxDepth = 3;
+    EXPECT_THROW(json::Object::Parser(options).fromString("{\"skip\": [[[1]]]}", projection), json::Error);
+}
+
+TEST(ParserTest, checkLazyNumbersKeepRawTextAndDecodeOnDemand)
+{
+    json::Object::Parser::Options options;
+    options.lazyNumbers = true;
+    const std::string input = "[1.50, -0, 12345678901234567890, 9223372036854775807, -9223372036854775808, 1E+2, 3.141592653589793238]";
+
+    json::Object obj = json::parse(input, options);
+    EXPECT_EQ(obj.dumps(false), "[1.50,-0,12345678901234567890,9223372036854775807,-9223372036854775808,1E+2,3.141592653589793238]");
+    EXPECT_EQ(obj[0].type(), json::Type::Double);
+    EXPECT_EQ(obj[0].toDouble(), 1.5);
+    EXPECT_EQ(obj[0].toDouble(), 1.5);
+    EXPECT_EQ(obj[1].toInteger(), 0);
+    EXPECT_EQ(obj[2].type(), json::Type::Double);
+    EXPECT_EQ(obj[3].toInteger(), INT64_MAX);
+    EXPECT_EQ(obj[4].toInteger(), INT64_MIN);
+    EXPECT_EQ(obj[5].toDouble(), 100.0);
+    EXPECT_THROW(obj[0].toInteger(), json::Error);
+    EXPECT_THROW(json::parse("1e999", options).toDouble(), json::Error);
+
+    EXPECT_EQ(json::parse(input, options), json::parse(input));
+    EXPECT_EQ(json::parse(input, options).hash(), json::parse(input).hash());
+
+    json::Object copy = obj;
+    EXPECT_EQ(copy[0].dumps(), "1.50");
+    copy[0] = 2.5;
+    EXPECT_EQ(copy[0].dumps(), "2.5");
+    EXPECT_EQ(obj[0].dumps(), "1.50");
+}
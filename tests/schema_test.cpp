@@ -0,0 +1,251 @@
+/**
+ * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
+ */
+
+#include <gtest/gtest.h>
+#include "json.h"
+
+using namespace testing;
+
+namespace {
+
+const char *personSchema = R"({
+    "type": "object",
+    "required": ["name", "age"],
+    "additionalProperties": false,
+    "properties": {
+        "name": {"type": "string", "minLength": 1, "maxLength": 6, "pattern": "^[^a-z]"},
+        "age": {"type": "integer", "minimum": 0, "exclusiveMaximum": 150},
+        "role": {"enum": ["admin", "user"]},
+        "tags": {"type": "array", "maxItems": 2, "items": {"type": "string"}}
+    }
+})";
+
+} // namespace
+
+TEST(SchemaTest, checkThatValidDocumentPassesValidation)
+{
+    json::Schema schema(json::parse(personSchema));
+    json::Object person = json::parse(R"({"name": "Łukasz", "age": 40, "role": "admin", "tags": ["a", "b"]})");
+
+    EXPECT_TRUE(schema.isValid(person));
+    EXPECT_NO_THROW(schema.validate(person));
+}
+
+TEST(SchemaTest, checkThatViolationsAreReportedWithPath)
+{
+    json::Schema schema(json::parse(personSchema));
+    std::list<std::pair<std::string, std::string>> samples{
+        {R"({"name": "Ann"})", "Schema violation at : missing required member 'age'"},
+        {R"({"name": "ann", "age": 1})", "Schema violation at /name: string does not match pattern"},
+        {R"({"name": "Annabelle", "age": 1})", "Schema violation at /name: string too long"},
+        {R"({"name": "Ann", "age": 150})", "Schema violation at /age: number too large"},
+        {R"({"name": "Ann", "age": 1.5})", "Schema violation at /age: unexpected type"},
+        {R"({"name": "Ann", "age": 1, "role": "root"})", "Schema violation at /role: value not allowed"},
+        {R"({"name": "Ann", "age": 1, "tags": ["a", 2]})", "Schema violation at /tags/1: unexpected type"},
+        {R"({"name": "Ann", "age": 1, "id": 7})", "Schema violation at /id: unexpected member"},
+    };
+
+    for (auto& [input, message]: samples)
+    {
+        json::Object value = json::parse(input);
+        EXPECT_FALSE(schema.isValid(value)) << input;
+        try
+        {
+            schema.validate(value);
+            FAIL() << input;
+        }
+        catch (const json::Error& error)
+        {
+            EXPECT_EQ(error.what(), message);
+        }
+    }
+}
+
+TEST(SchemaTest, checkThatViolationPathsEscapeMemberNames)
+{
+    json::Schema schema(json::parse(R"({"additionalProperties": {"type": "integer"}})"));
+
+    try
+    {
+        schema.validate(json::parse(R"({"a/b~c": "x"})"));
+        FAIL() << "json::Error expected";
+    }
+    catch (const json::Error& error)
+    {
+        EXPECT_STREQ(error.what(), "Schema violation at /a~1b~0c: unexpected type");
+    }
+}
+
+TEST(SchemaTest, checkThatPatternsFollowEcmaScriptSearchSemantics)
+{
+    auto matches = [](const char *pattern, const char *text) {
+        json::Object schema;
+        schema["pattern"] = pattern;
+        return json::Schema(schema).isValid(json::Object(text));
+    };
+
+    EXPECT_TRUE(matches("b+c", "aabbcc"));
+    EXPECT_FALSE(matches("^b+c", "aabbcc"));
+    EXPECT_TRUE(matches("^(ab|cd){2,3}$", "abcdab"));
+    EXPECT_FALSE(matches("^(ab|cd){2,3}$", "ab"));
+    EXPECT_FALSE(matches("^(ab|cd){2,3}$", "abcdabcd"));
+    EXPECT_TRUE(matches("^[a-z0-9_-]+@[^.]+\\.(com|org)$", "jan-k_1@example.org"));
+    EXPECT_FALSE(matches("^[a-z0-9_-]+@[^.]+\\.(com|org)$", "jan@example.net"));
+    EXPECT_TRUE(matches("^\\d{3}-\\d{4}$", "555-1234"));
+    EXPECT_FALSE(matches("^\\d{3}-\\d{4}$", "555-12345"));
+    EXPECT_TRUE(matches("\\bcat\\b", "a cat!"));
+    EXPECT_FALSE(matches("\\bcat\\b", "concatenate"));
+    EXPECT_TRUE(matches("^.{3}$", "\xC5\x81\xC3\xB3" "d"));
+    EXPECT_TRUE(matches("^[\\u0100-\\u017F]", "\xC5\x81"));
+    EXPECT_TRUE(matches("^(?:a*)*b$", "aaab"));
+    EXPECT_TRUE(matches("^a{,2}$", "a{,2}"));
+    EXPECT_TRUE(matches("", "anything"));
+}
+
+TEST(SchemaTest, checkThatPatternMatchingHandlesLongSubjects)
+{
+    json::Schema schema(json::parse(R"({"type": "string", "pattern": "^(a|b)*$"})"));
+    std::string subject(200000, 'a');
+
+    EXPECT_TRUE(schema.isValid(json::Object(subject)));
+    subject.back() = 'c';
+    EXPECT_FALSE(schema.isValid(json::Object(subject)));
+
+    json::Schema nested(json::parse(R"({"pattern": "^((a|aa)+)+$"})"));
+    EXPECT_FALSE(nested.isValid(json::Object(std::string(50000, 'a') + "!")));
+}
+
+TEST(SchemaTest, checkThatUnsupportedPatternsAreRejected)
+{
+    for (auto& pattern: {"(a", "a)", "*a", "a{2,1}", "[b-a]", "(?=a)", "(a)\\1", "a{100000}", "^*", "\\q"})
+    {
+        json::Object schema;
+        schema["pattern"] = pattern;
+        EXPECT_THROW(json::Schema{schema}, json::Error) << pattern;
+    }
+}
+
+TEST(SchemaTest, checkThatIntegralDoubleIsAcceptedAsInteger)
+{
+    json::Schema schema(json::parse(R"({"type": "integer"})"));
+
+    EXPECT_TRUE(schema.isValid(json::parse("2.0")));
+    EXPECT_FALSE(schema.isValid(json::parse("2.5")));
+}
+
+TEST(SchemaTest, checkThatInclusiveAndExclusiveBoundsAreCheckedTogether)
+{
+    json::Schema lower(json::parse(R"({"minimum": 5, "exclusiveMinimum": 0})"));
+    EXPECT_TRUE(lower.isValid(json::parse("5")));
+    EXPECT_FALSE(lower.isValid(json::parse("4.5")));
+
+    json::Schema reversed(json::parse(R"({"exclusiveMinimum": 10, "minimum": 0})"));
+    EXPECT_FALSE(reversed.isValid(json::parse("5")));
+    EXPECT_FALSE(reversed.isValid(json::parse("10")));
+    EXPECT_TRUE(reversed.isValid(json::parse("10.5")));
+
+    json::Schema upper(json::parse(R"({"maximum": 5, "exclusiveMaximum": 10})"));
+    EXPECT_TRUE(upper.isValid(json::parse("5")));
+    EXPECT_FALSE(upper.isValid(json::parse("7")));
+
+    json::Schema range(json::parse(R"({"exclusiveMaximum": 5, "maximum": 10})"));
+    EXPECT_FALSE(range.isValid(json::parse("5")));
+    EXPECT_TRUE(range.isValid(json::parse("4")));
+}
+
+TEST(SchemaTest, checkThatEnumAndConstCompareNumbersByValue)
+{
+    json::Schema numbers(json::parse(R"({"enum": [1, 2.5, [3, {"k": 4}]]})"));
+    EXPECT_TRUE(numbers.isValid(json::parse("1.0")));
+    EXPECT_TRUE(numbers.isValid(json::parse("1")));
+    EXPECT_TRUE(numbers.isValid(json::parse("2.5")));
+    EXPECT_TRUE(numbers.isValid(json::parse(R"([3.0, {"k": 4e0}])")));
+    EXPECT_FALSE(numbers.isValid(json::parse("1.5")));
+    EXPECT_FALSE(numbers.isValid(json::parse("\"1\"")));
+    EXPECT_FALSE(numbers.isValid(json::parse(R"([3, {"k": 4, "x": 5}])")));
+
+    json::Schema constant(json::parse(R"({"const": 2})"));
+    EXPECT_TRUE(constant.isValid(json::parse("2.0")));
+    EXPECT_FALSE(constant.isValid(json::parse("2.000001")));
+    EXPECT_FALSE(constant.isValid(json::parse("1e300")));
+
+    json::Object::Parser parser;
+    EXPECT_NO_THROW(parser.fromString("2.0", constant));
+}
+
+TEST(SchemaTest, checkThatBooleanSchemasAcceptOrRejectEverything)
+{
+    EXPECT_TRUE(json::Schema(json::parse("true")).isValid(json::parse(R"({"a": [1]})")));
+    EXPECT_FALSE(json::Schema(json::parse("false")).isValid(json::parse("null")));
+}
+
+TEST(SchemaTest, checkThatUnsupportedOrInvalidSchemaThrows)
+{
+    EXPECT_THROW(json::Schema(json::parse(R"({"$ref": "#/x"})")), json::Error);
+    EXPECT_THROW(json::Schema(json::parse(R"({"anyOf": []})")), json::Error);
+    EXPECT_THROW(json::Schema(json::parse(R"({"type": "float"})")), json::Error);
+    EXPECT_THROW(json::Schema(json::parse(R"({"minLength": -1})")), json::Error);
+
+    for (auto& invalid: {R"({"type": [1]})", R"({"required": [1]})", R"({"pattern": 1})"})
+    {
+        try
+        {
+            json::Schema schema(json::parse(invalid));
+            FAIL() << invalid;
+        }
+        catch (const json::Error& error)
+        {
+            EXPECT_STREQ(error.what(), "Invalid schema") << invalid;
+        }
+    }
+    EXPECT_THROW(json::Schema(json::parse(R"({"pattern": "("})")), json::Error);
+}
+
+TEST(SchemaTest, checkThatParsingWithSchemaReturnsValidDocument)
+{
+    json::Schema schema(json::parse(personSchema));
+    json::Object::Parser parser;
+
+    json::Object person = parser.fromString(R"({"name": "Ann", "age": 30, "tags": ["x"]})", schema);
+    EXPECT_EQ(person["name"].toString(), "Ann");
+    EXPECT_EQ(person["tags"].size(), 1);
+}
+
+TEST(SchemaTest, checkThatParsingWithSchemaFailsAtFirstViolation)
+{
+    json::Schema schema(json::parse(personSchema));
+    json::Object::Parser parser;
+    std::list<std::pair<std::string, std::size_t>> samples{
+        {R"({"name": 5, "age": 1})", 9},
+        {R"({"name": "Ann", "id": 1, "age": 1})", 16},
+        {R"({"name": "Ann", "tags": {}, "age": 1})", 24},
+        {R"({"name": "Ann", "tags": ["a", "b", "c"]})", 38},
+        {R"({"name": "Ann"})", 14},
+        {R"([])", 0},
+    };
+
+    for (auto& [input, offset]: samples)
+    {
+        try
+        {
+            parser.fromString(input, schema);
+            FAIL() << input;
+        }
+        catch (const json::Error& error)
+        {
+            EXPECT_EQ(error.offset(), offset) << input << ": " << error.what();
+        }
+    }
+}
+
+TEST(SchemaTest, checkThatParsingIntoExistingObjectWithSchemaKeepsResultOnSuccess)
+{
+    json::Schema schema(json::parse(R"({"type": "array", "items": {"type": "number", "minimum": 0}})"));
+    json::Object::Parser parser;
+    json::Object result;
+
+    parser.fromString("[1, 2.5, 3]", schema, result);
+    EXPECT_EQ(result.size(), 3);
+    EXPECT_THROW(parser.fromString("[1, -2]", schema, result), json::Error);
+}
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2023 by Łukasz Marcin Podkalicki <lpodkalicki@gmail.com>
+ */
+
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "json.h"
+
+using namespace testing;
+
+TEST(WriterTest, checkCompactOutputMatchesDumps)
+{
+    std::string output;
+    json::Writer writer(output);
+    writer.beginObject()
+          .key("key1").beginArray().value(1).value(2.5).value("a\"b").value(nullptr).endArray()
+          .key("key2").beginObject().key("key3").value(true).endObject()
+          .endObject();
+
+    EXPECT_TRUE(writer.isComplete());
+    EXPECT_EQ(output, "{\"key1\":[1,2.5,\"a\\\"b\",null],\"key2\":{\"key3\":true}}");
+    EXPECT_EQ(output, json::parse(output).dumps(false));
+}
+
+TEST(WriterTest, checkPrettyOutputMatchesDumps)
+{
+    json::Object obj{
+        {"key1"_, "value"},
+        {"key2"_, {{"key3"_, {{"key4"_, 1.0}}}}},
+        {"key6"_, {1, 2, 3, {{"key7"_, {{"key8"_, {1, true, 3.0, "abc"}}, {"key9"_, "test"}}}}}},
+        {"key10"_, json::Object(json::Type::Object)},
+        {"key11"_, json::Object(json::Type::Array)}
+    };
+
+    std::string output;
+    json::Writer writer(output, true);
+    writer.beginObject();
+    for (auto [key, value]: obj.items())
+    {
+        writer.key(key).value(value);
+    }
+    writer.endObject();
+    EXPECT_EQ(output, obj.dumps(true));
+}
+
+TEST(WriterTest, checkStreamOutputIsFlushedInChunks)
+{
+    std::ostringstream oss;
+    {
+        json::Writer writer(oss);
+        writer.beginArray();
+        for (int i = 0; i < 100000; ++i)
+        {
+            writer.value(i);
+        }
+        EXPECT_GT(oss.str().size(), 0);
+        writer.endArray();
+    }
+
+    json::Object obj = json::parse(oss.str());
+    EXPECT_EQ(obj.size(), 100000);
+    EXPECT_EQ(obj.at(99999).toInteger(), 99999);
+}
+
+TEST(WriterTest, checkFileDescriptorOutput)
+{
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+
+    json::Writer writer(fd);
+    writer.beginObject().key("key").value("value").endObject();
+    writer.flush();
+
+    char buffer[64] = {};
+    ASSERT_EQ(pread(fd, buffer, sizeof(buffer) - 1, 0), 15);
+    EXPECT_STREQ(buffer, "{\"key\":\"value\"}");
+    std::fclose(file);
+}
+
+#ifndef NDEBUG
+TEST(WriterTest, checkInvalidStructureIsRejectedInDebugBuilds)
+{
+    std::string output;
+    EXPECT_THROW(json::Writer(output).beginObject().value(1), json::Error);
+    EXPECT_THROW(json::Writer(output).beginArray().key("key"), json::Error);
+    EXPECT_THROW(json::Writer(output).beginArray().endObject(), json::Error);
+    EXPECT_THROW(json::Writer(output).beginObject().key("key").endObject(), json::Error);
+    EXPECT_THROW(json::Writer(output).value(1).value(2), json::Error);
+    EXPECT_THROW(json::Writer(output).endArray(), json::Error);
+}
+#endif